@@ -0,0 +1,243 @@
+#include "Asteroids.hpp"
+#include "Background.hpp"
+#include "Collisions.hpp"
+#include "TextureProvider.hpp"
+#include "World.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Every benchmark takes the entity count as its first argument. Benchmarks
+// using EntityArgs run with 1..N benchmark threads, each working on its own
+// objects, so the numbers show how the code behaves when several simulations
+// share the machine (allocator and cache contention). Benchmarks using
+// PoolArgs measure one simulation spread over a ThreadPool of N threads.
+
+namespace {
+
+const int MinEntities = 10;
+const int MaxEntities = 100000;
+
+int MaxThreads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void SetEntityCounters(benchmark::State &state, int64_t entities) {
+  state.SetItemsProcessed(state.iterations() * entities);
+  state.counters["ns/entity"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * entities) / 1e9,
+      benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+// Gives access to the protected spawning routine.
+class BenchAsteroids : public Asteroids {
+public:
+  using Asteroids::Asteroids;
+  using Asteroids::CreateAsteroids;
+};
+
+void BM_CheckCollisions(benchmark::State &state) {
+  const int count = state.range(0);
+  // Asteroids keep the spread of their constructor (8192x8192), the density
+  // at which a level is populated before the despawn radius kicks in.
+  std::vector<std::shared_ptr<GameObject>> objects;
+  Random random(42);
+  for (int i = 0; i < count; ++i) {
+    auto asteroid = std::make_shared<Asteroid>(random);
+    asteroid->setPosition(asteroid->getPos());
+    objects.push_back(asteroid);
+  }
+  ThreadPool pool(state.range(1));
+  CollisionState collisions;
+  registerGameCollisions(collisions.matrix);
+  for (auto _ : state)
+    checkCollisions(collisions, objects, 1.0f / 60.0f, pool);
+  SetEntityCounters(state, count);
+}
+
+void BM_AsteroidsTick(benchmark::State &state) {
+  const int count = state.range(0);
+  auto target = std::make_shared<Movable>();
+  Asteroids asteroids(target, count);
+  asteroids.tick(0);
+  for (auto _ : state)
+    asteroids.tick(1.0f / 60.0f);
+  SetEntityCounters(state, asteroids.getAsteroids().size());
+}
+
+void BM_AsteroidFieldTick(benchmark::State &state) {
+  const int count = state.range(0);
+  auto target = std::make_shared<Movable>();
+  Asteroids asteroids(target, count, true);
+  asteroids.tick(0);
+  for (auto _ : state) {
+    asteroids.tick(1.0f / 60.0f);
+    asteroids.checkFieldCollisions();
+  }
+  SetEntityCounters(state, asteroids.getField().size());
+}
+
+void BM_AsteroidFieldIntegrate(benchmark::State &state) {
+  const int count = state.range(0);
+  AsteroidField field;
+  for (int i = 0; i < count; ++i)
+    field.add({static_cast<float>(i % 1000), static_cast<float>(i / 1000)},
+              {1.0f, -1.0f});
+  for (auto _ : state) {
+    field.integrate(1.0f / 60.0f, {0, 0}, 1e9f);
+    benchmark::DoNotOptimize(field.x.data());
+  }
+  SetEntityCounters(state, count);
+}
+
+// One asteroid against a run of others, as the broad phase does a cell at a
+// time.
+void BM_OverlapMask(benchmark::State &state) {
+  const int count = state.range(0);
+  Random random(42);
+  PackedBounds bounds;
+  bounds.resize(count + 1);
+  for (int i = 0; i <= count; ++i) {
+    WorldBounds b;
+    b.left = random.uniform(0.0f, 1000.0f);
+    b.top = random.uniform(0.0f, 1000.0f);
+    b.right = b.left + 32;
+    b.bottom = b.top + 32;
+    b.center = {b.left + 16, b.top + 16};
+    b.radius = 16;
+    bounds.set(i, b);
+  }
+  std::vector<uint64_t> mask((count + 63) / 64);
+  for (auto _ : state) {
+    bounds.overlapMask(0, 1, count + 1, mask.data());
+    benchmark::DoNotOptimize(mask.data());
+  }
+  SetEntityCounters(state, count);
+}
+
+void BM_CreateAsteroids(benchmark::State &state) {
+  const int count = state.range(0);
+  auto target = std::make_shared<Movable>();
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto asteroids = std::make_unique<BenchAsteroids>(target, count);
+    state.ResumeTiming();
+    asteroids->CreateAsteroids();
+    benchmark::DoNotOptimize(asteroids->getAsteroids().data());
+    state.PauseTiming();
+    asteroids.reset();
+    state.ResumeTiming();
+  }
+  SetEntityCounters(state, count);
+}
+
+void BM_GenerateStars(benchmark::State &state) {
+  const int count = state.range(0);
+  const sf::Vector2i size(16384, 16384);
+  Background::Stars stars;
+  ThreadPool pool(state.range(1));
+  for (auto _ : state) {
+    Background::generateStars(stars, count, size, 42, pool);
+    benchmark::DoNotOptimize(stars.x.data());
+  }
+  SetEntityCounters(state, count);
+}
+
+// One 1024x1024 background tile with the given number of stars, rasterized
+// by a pool of the given size.
+void BM_RasterizeStars(benchmark::State &state) {
+  const int count = state.range(0);
+  const sf::Vector2i size(1024, 1024);
+  Background::Stars stars;
+  Background::generateStars(stars, count, size, 42);
+  std::vector<uint8_t> pixels(size.x * size.y);
+  ThreadPool pool(state.range(1));
+  for (auto _ : state) {
+    Background::rasterize(stars, size, pixels.data(), pool);
+    benchmark::DoNotOptimize(pixels.data());
+  }
+  SetEntityCounters(state, count);
+}
+
+void BM_GetTexture(benchmark::State &state) {
+  const int count = state.range(0);
+  const std::filesystem::path paths[] = {
+      "./assets/asteroid.png", "./assets/astronaut.png",
+      "./assets/spaceship_scaled.png", "./assets/Arrow.png"};
+  for (auto _ : state) {
+    for (int i = 0; i < count; ++i)
+      benchmark::DoNotOptimize(&TextureProvider::getTexture(paths[i % 4]));
+  }
+  SetEntityCounters(state, count);
+}
+
+// The same lookups through handles resolved up front.
+void BM_GetTextureHandle(benchmark::State &state) {
+  const int count = state.range(0);
+  const TextureHandle handles[] = {
+      TextureProvider::load("./assets/asteroid.png"),
+      TextureProvider::load("./assets/astronaut.png"),
+      TextureProvider::load("./assets/spaceship_scaled.png"),
+      TextureProvider::load("./assets/Arrow.png")};
+  for (auto _ : state) {
+    for (int i = 0; i < count; ++i) {
+      benchmark::DoNotOptimize(&TextureProvider::getTexture(handles[i % 4]));
+      benchmark::DoNotOptimize(TextureProvider::getRect(handles[i % 4]));
+    }
+  }
+  SetEntityCounters(state, count);
+}
+
+// For code that spreads its own work over a ThreadPool: the second argument
+// is the pool size and the benchmark itself runs on one thread.
+void PoolArgs(benchmark::internal::Benchmark *b) {
+  std::vector<int64_t> threads;
+  for (int t = 1; t < MaxThreads(); t *= 2)
+    threads.push_back(t);
+  threads.push_back(MaxThreads());
+  b->ArgsProduct(
+       {benchmark::CreateRange(MinEntities, MaxEntities, 10), threads})
+      ->ArgNames({"entities", "threads"})
+      ->UseRealTime()
+      ->Unit(benchmark::kMicrosecond);
+}
+
+void EntityArgs(benchmark::internal::Benchmark *b) {
+  b->RangeMultiplier(10)
+      ->Range(MinEntities, MaxEntities)
+      ->ThreadRange(1, MaxThreads())
+      ->UseRealTime()
+      ->Unit(benchmark::kMicrosecond);
+}
+
+} // namespace
+
+BENCHMARK(BM_CheckCollisions)->Apply(PoolArgs);
+BENCHMARK(BM_AsteroidsTick)->Apply(EntityArgs);
+BENCHMARK(BM_AsteroidFieldTick)->Apply(EntityArgs);
+BENCHMARK(BM_AsteroidFieldIntegrate)->Apply(EntityArgs);
+BENCHMARK(BM_OverlapMask)->Apply(EntityArgs);
+BENCHMARK(BM_CreateAsteroids)->Apply(EntityArgs);
+BENCHMARK(BM_GenerateStars)->Apply(PoolArgs);
+BENCHMARK(BM_RasterizeStars)->Apply(PoolArgs);
+BENCHMARK(BM_GetTexture)->Apply(EntityArgs);
+BENCHMARK(BM_GetTextureHandle)->Apply(EntityArgs);
+
+int main(int argc, char **argv) {
+  // Set once here, before any benchmark thread reads it. Texture lookups
+  // share TextureProvider's map, decode everything up front so the threads
+  // only ever read it.
+  HEADLESS = true;
+  for (auto path : {"./assets/asteroid.png", "./assets/astronaut.png",
+                    "./assets/spaceship_scaled.png", "./assets/Arrow.png"})
+    TextureProvider::load(path);
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
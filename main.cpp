@@ -1,626 +1,17 @@
+#include "Background.hpp"
+#include "FrameTimes.hpp"
+#include "Scenario.hpp"
+#include "Simulation.hpp"
+#include "WorldView.hpp"
 #include "fmt/base.h"
 #include <SFML/Graphics.hpp>
-#include <SFML/Graphics/CircleShape.hpp>
-#include <SFML/Graphics/Color.hpp>
-#include <SFML/Graphics/ConvexShape.hpp>
-#include <SFML/Graphics/Drawable.hpp>
-#include <SFML/Graphics/Font.hpp>
-#include <SFML/Graphics/Rect.hpp>
-#include <SFML/Graphics/RectangleShape.hpp>
-#include <SFML/Graphics/RenderWindow.hpp>
-#include <SFML/Graphics/Sprite.hpp>
-#include <SFML/Graphics/Text.hpp>
-#include <SFML/Graphics/Texture.hpp>
-#include <SFML/System/Vector2.hpp>
 #include <SFML/Window.hpp>
 #include <SFML/Window/Keyboard.hpp>
 #include <SFML/Window/WindowStyle.hpp>
+#include <args.hxx>
 #include <chrono>
-#define _USE_MATH_DEFINES
-#include <cmath>
-#include <filesystem>
 #include <fmt/format.h>
-#include <functional>
-#include <future>
 #include <iostream>
-#include <map>
-#include <memory>
-#include <string>
-#include <thread>
-#ifndef uint
-using uint = unsigned int;
-#endif
-int WINDOW_WIDTH = 1980;
-int WINDOW_HEIGHT = 1080;
-float VP_WIDTH = 0;
-float VP_HEIGHT = 0;
-const int MARGIN = 100;
-template <typename T> T VecLength(sf::Vector2<T> vec) {
-  return std::sqrt(vec.x * vec.x + vec.y * vec.y);
-}
-
-template <typename T> sf::Vector2<T> &normalize(sf::Vector2<T> &vec) {
-  auto len = VecLength(vec);
-  vec /= len;
-  return vec;
-}
-
-template <typename T> T PointLen(sf::Vector2<T> p0, sf::Vector2<T> p1) {
-  sf::Vector2<T> vec = {p0.x - p1.x, p0.y - p1.y};
-  return VecLength<T>(vec);
-}
-
-class TextureProvider {
-public:
-  static sf::Texture &getTexture(std::filesystem::path path) {
-    auto pathstring = path.string(); 
-    auto texture = textures.find(pathstring.c_str());
-    if (texture != textures.end()) {
-      return (*texture).second;
-    }
-    textures[pathstring] = generateTexture(path);
-    return getTexture(path);
-  }
-
-  static std::shared_ptr<sf::Font> getDefaultFont() {
-    std::cout << "Looking for default font" << std::endl;
-    if (defaultFont)
-      return defaultFont;
-    defaultFont = std::make_shared<sf::Font>();
-    auto path = std::filesystem::absolute("./fonts/Audiowide-Regular.ttf").string(); 
-    defaultFont->loadFromFile(path
-        );
-    std::cout << "default Font loaded" << std::endl;
-    return getDefaultFont();
-  }
-
-private:
-  static sf::Texture generateTexture(std::filesystem::path path) {
-    sf::Texture tmp;
-    auto pathString = std::filesystem::absolute(path).string(); 
-    tmp.loadFromFile(pathString.c_str());
-    tmp.setSmooth(true);
-    return tmp;
-  }
-
-  static std::map<std::string, sf::Texture> textures;
-  static std::shared_ptr<sf::Font> defaultFont;
-};
-
-std::map<std::string, sf::Texture> TextureProvider::textures = {};
-std::shared_ptr<sf::Font> TextureProvider::defaultFont = nullptr;
-
-class Drawable {
-public:
-  virtual void draw(sf::RenderWindow &rw) = 0;
-};
-
-class GameObject : public Drawable {
-public:
-  GameObject(std::filesystem::path texture, sf::Vector2f pos)
-      : sprite(TextureProvider::getTexture(texture)) {
-    sprite.setPosition(pos);
-  }
-
-  void setDefaultRect(sf::IntRect rec) {
-    sprite.setTextureRect(rec);
-    sprite.setOrigin({static_cast<float>(rec.width) / 2.0f,
-                      static_cast<float>(rec.height) / 2.0f});
-  }
-
-  const bool intersects(const GameObject &go) const {
-    return sprite.getGlobalBounds().intersects(go.sprite.getGlobalBounds());
-  }
-
-  virtual void onColision(std::weak_ptr<GameObject> obj, float dt) {}
-  virtual void draw(sf::RenderWindow &rw) override { rw.draw(sprite); }
-
-  void setPosition(sf::Vector2f pos) { sprite.setPosition(pos); }
-
-  const sf::Sprite &getSprite() const { return sprite; }
-
-protected:
-  sf::Sprite sprite;
-};
-
-struct inputs {
-  bool W = false;
-  bool S = false;
-  bool A = false;
-  bool D = false;
-  bool SPACE = false;
-};
-
-class Tickable {
-public:
-  virtual void tick(float dt) = 0;
-  virtual void tick(float dt, const inputs &input) { tick(dt); }
-};
-
-class Movable {
-public:
-  Movable() = default;
-  void setPos(float x, float y) {
-    pos.x = x;
-    pos.y = y;
-  }
-  void addAcc(float x, float y) {
-    acc.x += x;
-    acc.y += y;
-  }
-  void addAcc(sf::Vector2f app) { acc += app; }
-  void PhysicsTick(float dt, float maxSpeed = 0) {
-    if (maxSpeed != 0)
-      if (VecLength(acc) > maxSpeed)
-        normalize(acc) *= maxSpeed;
-    pos += acc * dt;
-  }
-
-  const sf::Vector2f getInverseAcc() const { return -acc; }
-  const sf::Vector2f &getPos() const { return pos; }
-
-protected:
-  sf::Vector2f pos;
-  sf::Vector2f acc = {0, 0};
-};
-
-class ProgressBar : public Drawable, public Tickable, public Movable {
-public:
-  ProgressBar(float val = 0, float maxVal = 100, float width = 256,
-              float height = 32)
-      : maxVal(maxVal), val(val) {
-    SliderWrapper.setSize({width, height});
-  }
-  void updateValue(float val) { this->val = val; }
-  virtual void draw(sf::RenderWindow &rw) override {
-    rw.draw(SliderWrapper);
-    rw.draw(ValueWrapper);
-  }
-  virtual void tick(float dt) override {
-    auto pos = getPos();
-    SliderWrapper.setPosition(pos);
-    pos.x += 5;
-    pos.y += 5;
-    ValueWrapper.setPosition(pos);
-    auto maxSize = SliderWrapper.getSize();
-    maxSize.x -= 10;
-    maxSize.y -= 10;
-    maxSize.x = maxSize.x * (val / maxVal);
-    ValueWrapper.setSize({maxSize.x, maxSize.y});
-  }
-  void setFillColor(sf::Color color) { ValueWrapper.setFillColor(color); }
-  void setBackgroundColor(sf::Color color) {
-    SliderWrapper.setFillColor(color);
-  }
-
-private:
-  float maxVal;
-  float val;
-  sf::RectangleShape SliderWrapper;
-  sf::RectangleShape ValueWrapper;
-};
-
-class Text : public Movable, public Tickable, public Drawable {
-public:
-  Text() : textCallback(nullptr) {
-    txt.setFont(*TextureProvider::getDefaultFont());
-    txt.setCharacterSize(12);
-    txt.setFillColor(sf::Color::White);
-  }
-  Text(std::shared_ptr<std::function<std::string()>> callback)
-      : textCallback(callback) {
-    txt.setFont(*TextureProvider::getDefaultFont());
-    txt.setCharacterSize(12);
-    txt.setFillColor(sf::Color::White);
-  }
-  void setText(std::string text) { txt.setString(text); }
-  void setColor(sf::Color col) { txt.setFillColor(col); }
-  void setFontSize(int fontSize) { txt.setCharacterSize(fontSize); }
-  virtual void tick(float dt) override {
-    txt.setPosition(getPos());
-    if (textCallback) {
-      std::string data = (*textCallback)();
-      txt.setString(data);
-    }
-  }
-  virtual void draw(sf::RenderWindow &rw) override { rw.draw(txt); }
-
-  sf::Text &getUnderlayingType() { return txt; }
-
-private:
-  sf::Text txt;
-  std::shared_ptr<std::function<std::string()>> textCallback;
-};
-
-class Arrow : public GameObject, public Movable, public Tickable {
-public:
-  Arrow() : GameObject("./assets/Arrow.png", {0, 0}) {
-    sprite.setScale(0.25, 0.25);
-    auto size = sprite.getTexture()->getSize();
-    sprite.setOrigin(size.x / 2, size.y / 2);
-  }
-  virtual void tick(float dt) override {
-    calculateAngle();
-    sf::Vector2f newPos = {0, -100};
-    float anglerad = -angle * (M_PI / 180.0f);
-    newPos.x = newPos.x * cos(anglerad) - newPos.y * sin(anglerad);
-    newPos.y = newPos.y * cos(anglerad) + newPos.x * sin(anglerad);
-    newPos += origin;
-    setPosition(newPos);
-    // idk why
-    sprite.setRotation(-angle);
-  }
-
-  void calculateAngle() {
-    auto t = target.lock()->getPos();
-
-    // Calculate angle using atan2 (result is in radians, range: -π to +π)
-    angle = std::atan2(origin.x - t.x, origin.y - t.y);
-
-    // Convert to degrees and normalize to [0, 360]
-    angle = angle * (180.0f / M_PI); // Convert radians to degrees
-    if (angle < 0) {
-      angle += 360.0f; // Ensure non-negative angle
-    }
-  }
-
-  void setAngle(float angle) { this->angle = angle; }
-  void setOrigin(sf::Vector2f origin) { this->origin = origin; }
-  void setTarget(std::weak_ptr<Movable> target) { this->target = target; }
-
-protected:
-  sf::Vector2f origin = {0, 0};
-  float angle = 0;
-  std::weak_ptr<Movable> target;
-};
-inline float PlayerGameScore = 0;
-class Player : public GameObject, public Movable, public Tickable {
-public:
-  Player(std::filesystem::path texture, sf::Vector2f pos)
-      : GameObject(texture, pos),
-        Position(std::make_shared<std::function<std::string()>>([this]() {
-          auto pos = getPos();
-          std::string data = fmt::format("X: {:.0f}, Y: {:.0f}", pos.x, pos.y);
-          return data;
-        })),
-        Acceleration(std::make_shared<std::function<std::string()>>([this]() {
-          std::string data =
-              fmt::format("X: {:.2f} m/s2, Y: {:.2f} m/s2", acc.x, acc.y);
-          return data;
-        })),
-        Points(std::make_shared<std::function<std::string()>>([this]() {
-          std::string data =
-              fmt::format("Score: {:.0f}", points + PlayerGameScore);
-          return data;
-        })),
-        PlayerShipStatus(
-            std::make_shared<std::function<std::string()>>([this]() {
-              std::string data = fmt::format(
-                  "Boarding fly around the ship for {:.0f}", 30.0f - dtShip);
-              return data;
-            })) {
-    PlayerShipStatus.setFontSize(32);
-    setPos(pos.x, pos.y);
-    oxygenSlider.setFillColor(sf::Color::Blue);
-    oxygenSlider.setBackgroundColor(sf::Color(115, 115, 115));
-    oxygenSlider.setPos(800, 800);
-    fuelSlider.setFillColor(sf::Color::Yellow);
-    fuelSlider.setBackgroundColor(sf::Color(115, 115, 115));
-    fuelSlider.setPos(800, 800);
-    setDefaultRect({0, 0, 52, 89});
-    sprite.scale(0.5, 0.5);
-  }
-  void Kill() {
-    using namespace std::literals;
-    if (creationTime - std::chrono::system_clock::now() > 15s)
-      return;
-    dead = true;
-    fuel = 0;
-    oxygen = 0;
-    addAcc(getInverseAcc());
-  }
-
-  bool isDead() { return oxygen <= 0; }
-  bool isWon() { return dtShip > 30; }
-
-  void addResources(float fuel, float oxygen) {
-    if (dead)
-      return;
-    this->fuel += fuel;
-    this->oxygen += oxygen;
-    if (this->fuel > 100.f)
-      this->fuel = 100;
-    if (this->oxygen > 100.f)
-      this->oxygen = 100;
-  }
-
-  void setTarget(std::weak_ptr<Movable> target) {
-    this->target = target;
-    arrow.setTarget(target);
-  }
-  virtual void tick(float dt) override {
-    internalTick(dt);
-    PhysicsTick(dt, maxSpeed);
-    oxygen -= dt * 1;
-    if (fuel == 0)
-      oxygen -= dt * 4;
-    if (oxygen <= 0)
-      oxygen = 0;
-    updateUIElements();
-  }
-
-  virtual void tick(float dt, const inputs &input) override {
-    if (dtShip > 30)
-      fmt::println("Player WON!");
-
-    tick(dt);
-    points = fuel * 0.2f + oxygen * 0.5f;
-    if (oxygen == 0)
-      return;
-    sf::Vector2f accAppend = {0, 0};
-    if (input.W)
-      accAppend.y -= accTickSpeed * dt;
-    if (input.S)
-      accAppend.y += accTickSpeed * dt;
-    if (input.D)
-      accAppend.x += accTickSpeed * dt;
-    if (input.A)
-      accAppend.x -= accTickSpeed * dt;
-    if (input.SPACE)
-      accAppend = getInverseAcc() * dt;
-    if (VecLength(accAppend) != 0 && fuel != 0)
-      fuel -= 5.f * dt;
-
-    if (fuel <= 0) {
-      accAppend = {0, 0};
-      fuel = 0;
-    }
-    addAcc(accAppend);
-  }
-  void updatePlayerGlobalScore() { PlayerGameScore += points; }
-  void updateTimer(float dt) { dtShip += dt; }
-  void zeroPlayerTimer() { dtShip = 0; }
-  Text &getPosition() { return Position; }
-
-  Text &getAcc() { return Acceleration; };
-
-  ProgressBar &getOxygenLevelSlider() { return oxygenSlider; }
-  ProgressBar &getFuelLevelSlider() { return fuelSlider; }
-  virtual void draw(sf::RenderWindow &rw) override {
-    if (!dead) {
-      oxygenSlider.draw(rw);
-      fuelSlider.draw(rw);
-      Position.draw(rw);
-      Acceleration.draw(rw);
-      Points.draw(rw);
-      if (dtShip > 0)
-        PlayerShipStatus.draw(rw);
-      if (PointLen(getPos(), target.lock()->getPos()) > 200.0f)
-        arrow.draw(rw);
-    }
-    rw.draw(this->sprite);
-  }
-
-private:
-  void updateUIElements() {
-    {
-      auto pos = getPos();
-      auto offsetRight = VP_WIDTH / 2.0f;
-      auto offsetBottom = VP_HEIGHT / 2.0f;
-      pos.x -= offsetRight - MARGIN;
-      pos.y += offsetBottom - 32;
-      oxygenSlider.setPos(pos.x, pos.y);
-    }
-    {
-      auto pos = getPos();
-      auto offsetRight = VP_WIDTH / 2.0f;
-      auto offsetBottom = VP_HEIGHT / 2.0f;
-      pos.x += offsetRight - 256 - MARGIN;
-      pos.y += offsetBottom - 32;
-
-      fuelSlider.setPos(pos.x, pos.y);
-    }
-    {
-      auto pos = getPos();
-      auto offsetRight = VP_WIDTH / 2.0f;
-      auto offsetBottom = VP_HEIGHT / 2.0f;
-      Points.setPos(pos.x - offsetRight, pos.y - offsetBottom);
-    }
-    {
-      auto pos = getPos();
-      auto &text = PlayerShipStatus.getUnderlayingType();
-      auto textRect = text.getLocalBounds();
-      text.setOrigin(textRect.left + textRect.width / 2.0f,
-                     textRect.top + textRect.height / 2.0f);
-      PlayerShipStatus.setPos(pos.x, pos.y - VP_HEIGHT / 4);
-    }
-    arrow.setOrigin(getPos());
-    setPosition(getPos());
-    auto realPos = getPos();
-    realPos.x += 50;
-    Position.setPos(realPos.x, realPos.y);
-    Acceleration.setPos(realPos.x, realPos.y + 12);
-
-    oxygenSlider.updateValue(oxygen);
-    fuelSlider.updateValue(fuel);
-  }
-
-  void internalTick(float dt) {
-    arrow.tick(dt);
-    Position.tick(dt);
-    Points.tick(dt);
-    PlayerShipStatus.tick(dt);
-    Acceleration.tick(dt);
-    oxygenSlider.tick(dt);
-    fuelSlider.tick(dt);
-  }
-
-protected:
-  bool dead = false;
-  float maxSpeed = 500.f;
-  float accTickSpeed = 100.f;
-  float fuel = 100.f;
-  float oxygen = 100.0f;
-  float points = 0;
-  float dtShip = 0.0f;
-  Text Position, Acceleration, Points, PlayerShipStatus;
-  ProgressBar oxygenSlider, fuelSlider;
-  Arrow arrow;
-  std::weak_ptr<Movable> target;
-  std::chrono::time_point<std::chrono::system_clock> creationTime =
-      std::chrono::system_clock::now();
-};
-
-class Spaceship : public Tickable, public Movable, public GameObject {
-public:
-  Spaceship(float minDistanceFromPlayer)
-      : GameObject("./assets/spaceship_scaled.png", {0, 0}) {
-    sf::Vector2f pos{static_cast<float>(rand() % 2048) - 1024 / 2,
-                     static_cast<float>(rand() % 2048) - 1024 / 2};
-    auto randomOffset = [](float min, float max) {
-      return min + static_cast<float>(rand()) /
-                       (static_cast<float>(RAND_MAX / (max - min)));
-    };
-
-    while (true) {
-      sf::Vector2f pos{randomOffset(-2048.0f, 2048.0f),
-                       randomOffset(-2048.0f, 2048.0f)};
-
-      // Ensure the spaceship is sufficiently far from the origin (player's
-      // initial position)
-      if (VecLength(pos) >= minDistanceFromPlayer) {
-        setPosition(pos);
-        setPos(pos.x, pos.y);
-        break;
-      }
-    }
-
-    auto rec = sprite.getTexture()->getSize();
-    setDefaultRect({0, 0, static_cast<int>(rec.x), static_cast<int>(rec.y)});
-  }
-  virtual void tick(float dt) override {
-    if (!PlayerRef)
-      return;
-    if (!intersects(*PlayerRef))
-      PlayerRef->zeroPlayerTimer();
-    if (intersects(*PlayerRef)) {
-      PlayerRef->updateTimer(dt);
-      PlayerRef->addResources(2.0f * dt, 10 * dt);
-    }
-  }
-  virtual void onColision(std::weak_ptr<GameObject> obj, float dt) override {
-    auto s_obj = obj.lock();
-    if (Player *player = dynamic_cast<Player *>(s_obj.get())) {
-      if (intersects(*player)) {
-        fmt::println("Player Found Ship!");
-        PlayerRef = player;
-      }
-    }
-  }
-
-private:
-  Player *PlayerRef = nullptr;
-};
-
-class Asteroid : public GameObject, public Movable, public Tickable {
-public:
-  Asteroid() : GameObject("./assets/asteroid.png", {0, 0}) {
-    auto maxSpeed = 50;
-    auto x = rand() % maxSpeed;
-    auto xSign = rand() % 2;
-    auto y = rand() % maxSpeed;
-    auto ySign = rand() % 2;
-    x *= (xSign % 2 ? 1 : -1);
-    y *= (ySign % 2 ? 1 : -1);
-    // addAcc(x, y);
-    sprite.setScale(0.5, 0.5);
-    auto max = 2048 * 4;
-    sf::Vector2f pos = {static_cast<float>(rand() % max) - max / 2,
-                        static_cast<float>(rand() % max) - max / 2};
-    if (std::abs(pos.x) < 150)
-      pos.x += xSign * 150;
-    if (std::abs(pos.y) < 150)
-      pos.y += ySign * 150;
-    setPos(pos.x, pos.y);
-  }
-  virtual void tick(float dt) override {
-    auto lastPos = getPos();
-    PhysicsTick(dt);
-    setPosition(getPos());
-    auto offset = getPos() - lastPos;
-    if (PlayerRef)
-      PlayerRef->setPos(offset.x + PlayerRef->getPos().x,
-                        offset.y + PlayerRef->getPos().y);
-    colided = false;
-  }
-
-  virtual void onColision(std::weak_ptr<GameObject> obj, float dt) override {
-    auto s_obj = obj.lock();
-    if (Player *player = dynamic_cast<Player *>(s_obj.get())) {
-      if (!isPlayerAttached)
-        if (intersects(*player)) {
-          fmt::println("Player Found Asteroid, will die!!");
-          player->Kill();
-          PlayerRef = player;
-          isPlayerAttached = true;
-        }
-    }
-    if (Asteroid *asteroid = dynamic_cast<Asteroid *>(s_obj.get())) {
-      if (!colided && !asteroid->colided && intersects(*asteroid)) {
-        // Get positions
-        sf::Vector2f pos1 = getPos();
-        sf::Vector2f pos2 = asteroid->getPos();
-
-        // Get velocities
-        sf::Vector2f vel1 = acc;
-        sf::Vector2f vel2 = asteroid->acc;
-
-        // Collision normal
-        sf::Vector2f collisionNormal = pos2 - pos1;
-        normalize(collisionNormal);
-
-        // Relative velocity
-        sf::Vector2f relativeVelocity = vel2 - vel1;
-
-        // Calculate velocity along the normal
-        float velocityAlongNormal = relativeVelocity.x * collisionNormal.x +
-                                    relativeVelocity.y * collisionNormal.y;
-
-        // Ignore if velocities are separating
-        if (velocityAlongNormal > 0) {
-          return;
-        }
-
-        // Coefficient of restitution (elasticity, range: 0.0 to 1.0)
-        float restitution = 0.8f;
-
-        // Impulse scalar
-        float impulseScalar = -(1.0f + restitution) * velocityAlongNormal;
-
-        // Assuming equal mass for simplicity
-        impulseScalar /= 2.0f;
-
-        // Impulse vector
-        sf::Vector2f impulse = impulseScalar * collisionNormal;
-
-        // Apply impulse to both objects
-        acc -= impulse;
-        asteroid->addAcc(impulse);
-
-        // Mark as collided
-        colided = true;
-        asteroid->colided = true;
-      }
-    }
-  }
-  ~Asteroid() { isPlayerAttached = false; }
-
-private:
-  Player *PlayerRef = nullptr;
-  bool colided = false;
-  static bool isPlayerAttached;
-};
-bool Asteroid::isPlayerAttached = false;
 
 void mapByKeyCode(const sf::Event event, const bool defaultVal, inputs &input) {
   switch (event.key.code) {
@@ -644,414 +35,369 @@ void mapByKeyCode(const sf::Event event, const bool defaultVal, inputs &input) {
   }
 }
 
-class Background : public Drawable {
-public:
-  Background(int amount, sf::Vector2i size, sf::Vector2i offset,
-             sf::RenderWindow &window, int threadCount = 4)
-      : textureSize(size) {
-    renderTexture.create(size.x, size.y);
-    renderTexture.clear(sf::Color::Black);
-
-    std::atomic<int> progressCounter(0); // Atomic counter for progress
-    std::vector<std::future<std::vector<sf::ConvexShape>>> futures;
-
-    // Divide star generation work among threads
-    int starsPerThread = amount / threadCount;
-
-    for (int t = 0; t < threadCount; ++t) {
-      futures.push_back(
-          std::async(std::launch::async, [=, &progressCounter, this]() {
-            auto stars = generateStars(starsPerThread, size);
-            progressCounter++; // Increment progress
-            return stars;
-          }));
-    }
-
-    // Main thread: Monitor progress and render the progress bar
-    int totalSteps = threadCount;
-    while (progressCounter < totalSteps) {
-      float progress = static_cast<float>(progressCounter) / totalSteps;
-      drawProgressBar(window, progress);
-      std::this_thread::sleep_for(std::chrono::milliseconds(50)); // Small delay
-    }
-
-    // Collect stars from threads and draw them
-    for (auto &future : futures) {
-      auto stars = future.get();
-      for (const auto &star : stars) {
-        renderTexture.draw(star);
-      }
-    }
-
-    // Finalize the texture
-    renderTexture.display();
-    backgroundSprite.setTexture(renderTexture.getTexture());
-    backgroundSprite.setPosition(-offset.x, -offset.y);
-
-    // Shader setup
-    if (!shader.loadFromMemory(blur, sf::Shader::Fragment)) {
-      throw std::runtime_error("Failed to load shader");
-    }
-
-    shader.setUniform("resolution", sf::Vector2f(textureSize.x, textureSize.y));
-    shader.setUniform("glowRadius", 1000.0f); // Glow radius
-    shader.setUniform("glowColor", sf::Glsl::Vec4(1.0, 1.0, 1.0, 0.5));
-  }
-
-  virtual void draw(sf::RenderWindow &rw) override {
-    auto &view = rw.getView();
-    auto viewSize = view.getSize();
-    sf::Vector2f cameraCenter = view.getCenter();
-    shader.setUniform("cameraCenter", cameraCenter); // Pass camera position
-    shader.setUniform("viewSize", viewSize);         // Pass view size
-    rw.draw(backgroundSprite, &shader);
-  }
-
-private:
-  void drawProgressBar(sf::RenderWindow &window, float progress) {
-    // Handle window events to keep the window responsive
-    sf::Event ev;
-    while (window.pollEvent(ev)) {
-      if (ev.type == sf::Event::Closed) {
-        window.close();
-      }
-    }
-
-    // Background bar
-    sf::RectangleShape barBackground({400.0f, 30.0f});
-    barBackground.setFillColor(sf::Color(50, 50, 50)); // Dark gray
-    barBackground.setPosition(600.0f, 500.0f);         // Center position
-
-    // Progress bar (fill)
-    sf::RectangleShape barFill({400.0f * progress, 30.0f});
-    barFill.setFillColor(sf::Color(100, 250, 100)); // Green
-    barFill.setPosition(600.0f, 500.0f); // Same position as background
-
-    // Clear and draw
-    window.clear(sf::Color::Black);
-    window.draw(barBackground);
-    window.draw(barFill);
-    window.display();
-  }
-  std::vector<sf::ConvexShape> generateStars(int amount, sf::Vector2i size) {
-    std::vector<sf::ConvexShape> stars;
-
-    for (int i = 0; i < amount; ++i) {
-      float x = static_cast<float>((std::rand() % size.x));
-      float y = static_cast<float>((std::rand() % size.y));
-      float outerRadius =
-          static_cast<float>(3 + (std::rand() % 5)); // Random size
-      float innerRadius = outerRadius / 2.5f;
-
-      stars.push_back(createStar(x, y, outerRadius, innerRadius));
-    }
-
-    return stars;
-  }
-
-  sf::ConvexShape createStar(float x, float y, float radius, float innerRadius,
-                             int points = 5) {
-    sf::ConvexShape star(points * 2);
-
-    const float angleStep = 2 * 3.14159265f / points;
-
-    for (int i = 0; i < points * 2; ++i) {
-      float radiusToUse = (i % 2 == 0) ? radius : innerRadius;
-      float angle = i * (angleStep / 2);
-
-      float vx = x + std::cos(angle) * radiusToUse;
-      float vy = y + std::sin(angle) * radiusToUse;
-
-      star.setPoint(i, sf::Vector2f(vx, vy));
-    }
-
-    star.setFillColor(getRandomStarColor());
-    return star;
-  }
-  sf::Color getRandomStarColor() {
-    int brightness =
-        (std::rand() % 256); // Range: 200 to 255 for shades of white
-    return sf::Color(brightness, brightness, brightness);
-  }
-
-  sf::RenderTexture renderTexture;
-  sf::Sprite backgroundSprite;
-  sf::Vector2i textureSize;
-  sf::Shader shader;
-  std::string blur = R"(uniform sampler2D texture;      // The input texture
-uniform vec2 resolution;        // Resolution of the texture
-uniform vec2 cameraCenter;      // Camera/view center
-uniform vec2 viewSize;          // Camera/view size
-uniform float glowRadius;       // Radius of the glow
-uniform vec4 glowColor;         // Color and intensity of the glow
-
-void main() {
-    vec2 uv = gl_FragCoord.xy / resolution;
-    vec4 original = texture2D(texture, uv); // Fetch original color
-    vec4 glow = vec4(0.0);
-
-    // Convert current fragment to world coordinates
-    vec2 worldPos = uv * resolution;
-
-    // Check if the fragment is within the visible camera area
-    vec2 halfViewSize = viewSize / 2.0;
-    if (worldPos.x < (cameraCenter.x - halfViewSize.x) - glowRadius ||
-        worldPos.x > (cameraCenter.x + halfViewSize.x) + glowRadius ||
-        worldPos.y < (cameraCenter.y - halfViewSize.y) - glowRadius ||
-        worldPos.y > (cameraCenter.y + halfViewSize.y) + glowRadius) {
-        gl_FragColor = original; // Skip glow calculation outside the view
-        return;
-    }
-
-    // Compute glow only for visible fragments
-    float radius = glowRadius / resolution.x; // Normalize glow radius
-    int samples = 32; // Number of samples for smooth glow
-
-    for (int i = 0; i < samples; ++i) {
-        float angle = 2.0 * 3.14159265 * (float(i) / float(samples));
-        vec2 offset = vec2(cos(angle), sin(angle)) * radius;
-        vec2 sampleUV = uv + offset;
-
-        float dist = length(offset) / radius; // Distance-based falloff
-        float falloff = 1.0 - dist;           // Linear falloff
-        falloff = max(falloff, 0.0);
-
-        glow += texture2D(texture, sampleUV) * glowColor * falloff;
-    }
+// The sky does not depend on the level, every level flies through the same one.
+const uint64_t SKY_SEED = 0x5eedc0ffee;
 
-    glow /= float(samples);  // Average the glow effect
-    gl_FragColor = original + glow; // Combine original color with glow
-}
-)";
+// What to do with a level besides playing it, every part is optional.
+struct Session {
+  Recording *record = nullptr;       // appends the input of every tick
+  const Recording *replay = nullptr; // takes the input of every tick from here
+  FrameTimes *frameTimes = nullptr;  // duration of every frame
 };
 
-void checkCollisions(const std::vector<std::shared_ptr<GameObject>> &objects,
-                     float dt) {
-  const int GRID_SIZE = 200; // Size of each grid cell
-
-  // Hash function to determine grid cell
-  auto getGridCell = [](const sf::Vector2f &pos) {
-    return sf::Vector2i{static_cast<int>(pos.x) / GRID_SIZE,
-                        static_cast<int>(pos.y) / GRID_SIZE};
-  };
-  struct Vector2iComparator {
-    bool operator()(const sf::Vector2i &lhs, const sf::Vector2i &rhs) const {
-      if (lhs.x != rhs.x)
-        return lhs.x < rhs.x;
-      return lhs.y < rhs.y;
-    }
-  };
-  std::map<sf::Vector2i, std::vector<std::shared_ptr<GameObject>>,
-           Vector2iComparator>
-      grid;
-
-  // Place objects into grid cells
-  for (auto &obj : objects) {
-    sf::Vector2i cell = getGridCell(obj->getSprite().getPosition());
-    grid[cell].push_back(obj);
-  }
-
-  // Check collisions within each cell and neighboring cells
-  for (auto &[cell, cellObjects] : grid) {
-    // Check within current cell
-    for (size_t i = 0; i < cellObjects.size(); ++i) {
-      for (size_t j = i + 1; j < cellObjects.size(); ++j) {
-        cellObjects[i]->onColision(cellObjects[j], dt);
-      }
-    }
-
-    // Check neighboring cells
-    for (int dx = -1; dx <= 1; ++dx) {
-      for (int dy = -1; dy <= 1; ++dy) {
-        sf::Vector2i neighbor = cell + sf::Vector2i(dx, dy);
-        if (grid.count(neighbor)) {
-          for (auto &obj1 : cellObjects) {
-            for (auto &obj2 : grid[neighbor]) {
-              if (obj1 != obj2) {
-                obj1->onColision(obj2, dt);
-              }
-            }
-          }
-        }
-      }
-    }
-  }
-}
-class Asteroids : public Drawable, public Tickable {
-public:
-  Asteroids(std::weak_ptr<Movable> target, int maxAsteroids)
-      : target(target), maxAsteroids(10 + maxAsteroids), maxDistance(1000) {}
-  virtual void draw(sf::RenderWindow &rw) override {
-    for (auto &asteroid : asteroids)
-      asteroid->draw(rw);
-  }
-  virtual void tick(float df) override {
-    asteroids.erase(
-        std::remove_if(asteroids.begin(), asteroids.end(),
-                       [&](const std::shared_ptr<Asteroid> &asteroid) {
-                         return PointLen(target.lock()->getPos(),
-                                         asteroid->getPos()) > maxDistance;
-                       }),
-        asteroids.end());
-    if (asteroids.size() < maxAsteroids)
-      CreateAsteroids();
-    for (auto &asteroid : asteroids)
-      asteroid->tick(df);
-  }
-  const std::vector<std::shared_ptr<Asteroid>> &getAsteroids() const {
-    return asteroids;
-  }
-
-protected:
-  void CreateAsteroids() {
-    int toCreate = maxAsteroids - asteroids.size();
-    auto targetPos = target.lock()->getPos();
-    while (--toCreate) {
-      auto asteroid = std::make_shared<Asteroid>();
-
-      // Random initial position for the asteroid
-      sf::Vector2f initialPos = {
-          static_cast<float>(rand() % (2 * maxDistance)) - maxDistance,
-          static_cast<float>(rand() % (2 * maxDistance)) - maxDistance};
-
-      // Ensure the asteroid is placed outside a minimum radius from the target
-      while (PointLen(initialPos, targetPos) < 450.0f) {
-        initialPos = {
-            static_cast<float>(rand() % (2 * maxDistance)) - maxDistance,
-            static_cast<float>(rand() % (2 * maxDistance)) - maxDistance};
-      }
-
-      asteroid->setPos(initialPos.x, initialPos.y);
-
-      // Calculate direction vector towards the target
-      sf::Vector2f direction = targetPos - initialPos;
-
-      // Add randomness to the direction
-      direction.x +=
-          static_cast<float>(rand() % 200 - 100) * 0.1f; // Small random offset
-      direction.y += static_cast<float>(rand() % 200 - 100) * 0.1f;
-
-      // Normalize and scale the direction vector to set velocity
-      normalize(direction);
-      float speed = 50.0f + static_cast<float>(
-                                rand() % 50); // Random speed between 50 and 100
-      sf::Vector2f velocity = direction * speed;
-
-      // Set the asteroid's velocity (via acceleration for simplicity)
-      asteroid->addAcc(velocity);
-
-      asteroids.push_back(asteroid);
-    }
-  }
-
-private:
-  int maxAsteroids = 10;
-  int maxDistance = 1000;
-  std::vector<std::shared_ptr<Asteroid>> asteroids;
-  std::weak_ptr<Movable> target;
-};
-
-std::tuple<bool, bool> StartLevel(sf::RenderWindow &window, int level) {
+std::tuple<bool, bool> StartLevel(sf::RenderWindow &window, int level,
+                                  WorldOptions options, float tickRate,
+                                  std::shared_ptr<Background> bg,
+                                  ProfilerOverlay &overlay, Session session) {
   std::cout << "Hello from the stars" << std::endl;
-  const uint StarsSize = 16384;
-  fmt::println("Placing the Spaceship");
-  float minDistanceFromPlayer = 512.0f + level * 100.0f;
-  std::shared_ptr<Spaceship> spaceship =
-      std::make_shared<Spaceship>(minDistanceFromPlayer);
+  World world(level, options);
+  auto &player = world.player;
 
   WINDOW_WIDTH = window.getSize().x;
   WINDOW_HEIGHT = window.getSize().y;
   VP_WIDTH = WINDOW_WIDTH / 4.f;
   VP_HEIGHT = VP_HEIGHT / 4.0f;
 
-  fmt::println("Drawing the stars on the sky");
-  auto bg = std::make_shared<Background>(
-      1e6, sf::Vector2i(StarsSize, StarsSize),
-      sf::Vector2i(StarsSize / 2, StarsSize / 2), window);
-  std::vector<std::shared_ptr<Drawable>> drawable = {bg, spaceship};
-  std::vector<std::shared_ptr<Tickable>> tickable = {spaceship};
-  std::vector<std::shared_ptr<GameObject>> colisable = {spaceship};
-  std::shared_ptr<Player> player = std::make_shared<Player>(
-      std::filesystem::path("./assets/astronaut.png"), sf::Vector2f{0, 0});
-  std::shared_ptr<Asteroids> asteroids =
-      std::make_shared<Asteroids>(player, level);
-  drawable.push_back(asteroids);
-  tickable.push_back(asteroids);
-  player->setTarget(spaceship);
-  drawable.push_back(player);
-  tickable.push_back(player);
-  colisable.push_back(player);
+  WorldView worldView(world);
+  Simulation simulation(world, tickRate);
+  simulation.setReplay(session.replay);
+  simulation.setRecording(session.record);
+  WorldSnapshot previous, current;
   inputs input;
+  SpriteBatch batch;
   sf::Clock deltaClock, fpsClock;
   int frameCount = 0;
   float fps = 0.0f;
   sf::View view(sf::FloatRect(0.0f, 0.0f, VP_WIDTH, VP_HEIGHT));
   window.setView(view);
-  while (window.isOpen() && !player->isWon() && !player->isDead()) {
-    sf::Event event;
-    while (window.pollEvent(event)) {
-      switch (event.type) {
-      case sf::Event::Closed:
-        window.close();
-        break;
-      case sf::Event::KeyPressed:
-        mapByKeyCode(event, true, input);
-        break;
-      case sf::Event::KeyReleased:
-        mapByKeyCode(event, false, input);
-        break;
-      default:
-        break;
+  simulation.start();
+  while (window.isOpen() && !simulation.isOver()) {
+    PROFILE_SCOPE("Frame");
+    {
+      PROFILE_SCOPE("Events");
+      sf::Event event;
+      while (window.pollEvent(event)) {
+        switch (event.type) {
+        case sf::Event::Closed:
+          window.close();
+          break;
+        case sf::Event::KeyPressed:
+          if (event.key.code == sf::Keyboard::F3 && Profiler::isEnabled())
+            overlay.toggle();
+          mapByKeyCode(event, true, input);
+          break;
+        case sf::Event::KeyReleased:
+          mapByKeyCode(event, false, input);
+          break;
+        default:
+          break;
+        }
       }
+      simulation.setInput(input);
     }
-    window.clear(sf::Color::Black);
-    for (auto toDraw : drawable)
-      toDraw->draw(window);
-    view.setCenter(player->getPos());
+    {
+      PROFILE_SCOPE("Read snapshot");
+      float alpha = simulation.read(previous, current);
+      float frameDt = deltaClock.restart().asSeconds();
+      if (session.frameTimes)
+        session.frameTimes->add(frameDt * 1000.0);
+      worldView.update(previous, current, alpha, simulation.getDt(), frameDt);
+    }
+    view.setCenter(worldView.getCenter());
     WINDOW_WIDTH = window.getSize().x;
     WINDOW_HEIGHT = window.getSize().y;
     VP_WIDTH = WINDOW_WIDTH / 2.f;
     VP_HEIGHT = WINDOW_HEIGHT / 2.f;
     view.setSize({VP_WIDTH, VP_HEIGHT});
     window.setView(view);
-    window.display();
-    sf::Time dt = deltaClock.restart();
-    for (auto tick : tickable)
-      tick->tick(dt.asSeconds(), input);
+
+    window.clear(sf::Color::Black);
+    {
+      PROFILE_SCOPE("Draw background");
+      bg->drawBatched(window, batch);
+    }
+    {
+      PROFILE_SCOPE("Draw world");
+      worldView.drawBatched(window, batch);
+    }
+    {
+      PROFILE_SCOPE("Flush sprites");
+      batch.flush(window);
+    }
+    overlay.draw(window);
+    {
+      PROFILE_SCOPE("Display");
+      window.display();
+    }
+    {
+      // Uploads of assets prefetched late, without stalling the frame or
+      // moving the atlas under a tick.
+      PROFILE_SCOPE("Pump textures");
+      simulation.betweenTicks(
+          [] { TextureProvider::pump(std::chrono::milliseconds(2)); });
+    }
 
     frameCount++;
     if (fpsClock.getElapsedTime().asSeconds() >= 1.0f) {
       fps = frameCount / fpsClock.getElapsedTime().asSeconds();
-      std::cout << "FPS: " << fps << std::endl;
+      auto &cull = worldView.getCullStats();
+      std::cout << "FPS: " << fps << ", drawn " << cull.drawn << ", culled "
+                << cull.culled << std::endl;
 
       // Reset for the next second
       frameCount = 0;
       fpsClock.restart();
     }
-    colisable.clear();
-    colisable.push_back(player);
-    colisable.push_back(spaceship);
-    for (auto &asteroid : asteroids->getAsteroids())
-      colisable.push_back(asteroid);
-    checkCollisions(colisable, dt.asSeconds());
   }
-  if (player->isWon())
-    player->updatePlayerGlobalScore();
-  else
-    PlayerGameScore = 0;
+  simulation.stop();
+  finishLevel(*player);
   return {player->isWon(), player->isDead()};
 }
 
-int main() {
+// Runs a level without a window at a fixed timestep, as fast as the machine
+// allows. Stops when the level is over, the replay ran out or after maxTicks
+// (0 = no limit). Every tick counts as a frame.
+std::tuple<bool, bool> StartHeadlessLevel(int level, WorldOptions options,
+                                          uint64_t maxTicks, float tickRate,
+                                          Session session) {
+  World world(level, options);
+  inputs input;
+  const float dt = 1.0f / tickRate;
+  uint64_t ticks = 0;
+  auto start = std::chrono::steady_clock::now();
+  while (!world.isOver() && (maxTicks == 0 || ticks < maxTicks)) {
+    if (session.replay) {
+      if (ticks >= session.replay->size())
+        break;
+      input = session.replay->at(ticks);
+    }
+    if (session.record)
+      session.record->add(input);
+    auto tickStart = std::chrono::steady_clock::now();
+    world.tick(dt, input);
+    if (session.frameTimes)
+      session.frameTimes->add(
+          std::chrono::duration<double, std::milli>(
+              std::chrono::steady_clock::now() - tickStart)
+              .count());
+    ticks++;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  fmt::println("Headless level {}: {} ticks ({:.1f}s simulated) in {:.3f}s, "
+               "{:.0f} ticks/s",
+               level + 1, ticks, ticks * dt, elapsed.count(),
+               ticks / std::max(elapsed.count(), 1e-9));
+  auto &pool = world.asteroids->getPoolStats();
+  fmt::println("Asteroids: {} spawns, at most {} of {} pooled in play, {} "
+               "dormant, {} woken",
+               pool.spawns, pool.highWater, pool.capacity, pool.dormant,
+               pool.woken);
+  finishLevel(*world.player);
+  return {world.player->isWon(), world.player->isDead()};
+}
+
+int main(int argc, char **argv) {
   using sc = std::chrono::system_clock;
   using tp = std::chrono::time_point<sc>;
   using namespace std::chrono_literals;
-  srand(time(NULL));
+  args::ArgumentParser parser("Among The Stars");
+  args::HelpFlag help(parser, "help", "Display this help menu", {'h', "help"});
+  args::Flag headless(parser, "headless",
+                      "Simulate without a window and report ticks per second",
+                      {"headless"});
+  args::ValueFlag<uint64_t> ticks(
+      parser, "ticks", "Headless: stop after N ticks (0 = until level ends)",
+      {"ticks"}, 0);
+  args::ValueFlag<int> startLevel(parser, "level", "Level to start at",
+                                  {"level"}, 0);
+  args::ValueFlag<float> tickRate(parser, "rate",
+                                  "Fixed ticks per simulated second",
+                                  {"tick-rate"}, 60.0f);
+  args::Flag asteroidField(
+      parser, "asteroid-field",
+      "Store asteroids as flat arrays with a vectorized integrator",
+      {"asteroid-field"});
+  args::ValueFlag<uint64_t> seed(
+      parser, "seed", "Seed of the level layouts (default: from the clock)",
+      {"seed"});
+  args::ValueFlag<std::string> record(
+      parser, "file", "Record the seed and inputs of the first level played",
+      {"record"});
+  args::ValueFlag<std::string> replay(
+      parser, "file", "Play a recorded level back, headless or in the window",
+      {"replay"});
+  args::ValueFlag<std::string> frameTimes(
+      parser, "file", "Write the duration of every frame as CSV",
+      {"frame-times"});
+  args::ValueFlag<int> maxAsteroids(
+      parser, "n", "Asteroids in play at most (0 = 10 + level)",
+      {"asteroids"}, 0);
+  args::ValueFlag<int> gridSize(parser, "pixels", "Collision grid cell size",
+                                {"grid-size"}, WorldOptions().gridSize);
+  args::ValueFlag<int> dormant(
+      parser, "n",
+      "Asteroids kept flying out of range, to come back later (0 = despawn)",
+      {"dormant"}, WorldOptions().dormantAsteroids);
+  args::ValueFlag<unsigned> threads(
+      parser, "n", "Threads of the job system (0 = one per core)",
+      {"threads"}, 0);
+  args::ValueFlag<float> starDensity(
+      parser, "density", "Background stars per square pixel", {"star-density"},
+      STAR_DENSITY);
+  args::ValueFlag<int> tileSize(parser, "pixels", "Background tile size",
+                                {"tile-size"}, 1024);
+  args::Flag scenario(
+      parser, "scenario",
+      "Tick a level headless for --ticks (default 600) whatever happens to "
+      "the player and report frame, tick, collision and tile timings",
+      {"scenario"});
+  args::ValueFlag<std::string> sweep(
+      parser, "knob=from:to[:factor]",
+      "Scenario: repeat for every value of a knob (asteroids, grid-size, "
+      "dormant, threads, star-density, tile-size), multiplied by factor (10) "
+      "each time",
+      {"sweep"});
+  args::ValueFlag<std::string> csv(parser, "file",
+                                   "Scenario: write one CSV row per point",
+                                   {"csv"});
+  args::ValueFlag<std::string> backgroundCache(
+      parser, "dir",
+      "Directory keeping generated background tiles (empty = no cache)",
+      {"background-cache"}, "cache");
+  args::Flag profile(parser, "profile",
+                     "Record profiler scopes, F3 toggles the overlay",
+                     {"profile"});
+  args::ValueFlag<std::string> trace(
+      parser, "file", "Write the profiler scopes as a Chrome trace on exit",
+      {"trace"});
+  try {
+    parser.ParseCLI(argc, argv);
+  } catch (const args::Help &) {
+    std::cout << parser;
+    return 0;
+  } catch (const args::Error &e) {
+    std::cerr << e.what() << std::endl << parser;
+    return 1;
+  }
+  if (args::get(tickRate) <= 0) {
+    std::cerr << "--tick-rate has to be positive" << std::endl;
+    return 1;
+  }
+  // Set before anything is packed, a headless run has no GL context.
+  HEADLESS = headless || scenario;
+  if (!Background::isValidTileSize(args::get(tileSize))) {
+    std::cerr << "--tile-size has to be a multiple of 16 above 16" << std::endl;
+    return 1;
+  }
+  // Written however main returns.
+  struct TraceOnExit {
+    std::string path;
+    ~TraceOnExit() {
+      if (!path.empty() && !Profiler::writeChromeTrace(path))
+        std::cerr << "Could not write trace " << path << std::endl;
+    }
+  } traceOnExit{args::get(trace)};
+  Profiler::setEnabled(args::get(profile) || trace);
+  ThreadPool::setGlobalSize(args::get(threads));
+  prefetchLevelAssets();
+  WorldOptions options;
+  options.asteroidField = args::get(asteroidField);
+  options.maxAsteroids = args::get(maxAsteroids);
+  options.gridSize = args::get(gridSize);
+  options.dormantAsteroids = args::get(dormant);
+  options.seed = seed ? args::get(seed)
+                      : static_cast<uint64_t>(
+                            sc::now().time_since_epoch().count());
+  int level = args::get(startLevel);
+  float rate = args::get(tickRate);
+  Recording played, recorded;
+  FrameTimes times;
+  Session session;
+  if (replay) {
+    if (!played.load(args::get(replay))) {
+      std::cerr << "Not a recording: " << args::get(replay) << std::endl;
+      return 1;
+    }
+    level = played.level;
+    rate = played.tickRate;
+    options = played.options;
+    session.replay = &played;
+  }
+  // Waits for the textures prefetched above.
+  if (options.gridSize < minGridSize()) {
+    std::cerr << "The grid size has to be at least " << minGridSize()
+              << ", the farthest apart two touching objects can be"
+              << std::endl;
+    return 1;
+  }
+  if (record) {
+    recorded.level = level;
+    recorded.tickRate = rate;
+    recorded.options = options;
+    session.record = &recorded;
+  }
+  if (replay || frameTimes)
+    session.frameTimes = &times;
+  auto finishSession = [&] {
+    if (record && !recorded.save(args::get(record)))
+      std::cerr << "Could not write " << args::get(record) << std::endl;
+    times.report("Frame times");
+    if (frameTimes && !times.write(args::get(frameTimes)))
+      std::cerr << "Could not write " << args::get(frameTimes) << std::endl;
+  };
+  fmt::println("World seed: {}", options.seed);
+  if (scenario) {
+    Scenario base;
+    base.level = level;
+    base.ticks = ticks ? args::get(ticks) : base.ticks;
+    base.tickRate = rate;
+    base.world = options;
+    base.threads = args::get(threads);
+    base.starDensity = args::get(starDensity);
+    base.tileSize = args::get(tileSize);
+    std::string knob;
+    double from = 0, to = 0, factor = 10;
+    if (sweep) {
+      auto spec = args::get(sweep);
+      auto equals = spec.find('=');
+      knob = spec.substr(0, equals);
+      if (equals == std::string::npos ||
+          std::sscanf(spec.c_str() + equals + 1, "%lf:%lf:%lf", &from, &to,
+                      &factor) < 2) {
+        std::cerr << "Expected --sweep knob=from:to[:factor], got " << spec
+                  << std::endl;
+        return 1;
+      }
+    }
+    if (!runSweep(base, knob, from, to, factor, args::get(csv))) {
+      std::cerr << "Could not run the sweep" << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+  if (headless) {
+    StartHeadlessLevel(level, options, args::get(ticks), rate, session);
+    finishSession();
+    return 0;
+  }
   sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT),
                           "Among The Stars");
-  int level = 0;
+  // Kept across levels, tiles already seen are not generated again.
+  auto bg = std::make_shared<Background>(args::get(starDensity), SKY_SEED,
+                                         args::get(tileSize), 16,
+                                         args::get(backgroundCache));
+  ProfilerOverlay overlay;
   while (window.isOpen()) {
-    auto [isWon, isDead] = StartLevel(window, level);
+    auto [isWon, isDead] =
+        StartLevel(window, level, options, rate, bg, overlay, session);
+    // Only the first level is recorded and timed, a replay ends after it.
+    if (session.record || session.replay || session.frameTimes) {
+      finishSession();
+      session = {};
+      if (replay)
+        return 0;
+    }
     sf::View view(sf::FloatRect(0.0f, 0.0f, VP_WIDTH, VP_HEIGHT));
     tp timer_start = sc::now();
     Text txt(std::make_shared<std::function<std::string()>>(
@@ -0,0 +1,294 @@
+#pragma once
+#include "Overlap.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Asteroids stored as parallel arrays instead of one heap object each. The
+// integrator walks the arrays in a single pass, eight or four lanes at a time
+// where the CPU allows it.
+class AsteroidField {
+public:
+  enum Flags : uint8_t {
+    Colided = 1, // took part in a bounce this tick
+    Far = 2,     // beyond the despawn distance after the last integrate
+  };
+
+  size_t size() const { return x.size(); }
+  bool empty() const { return x.empty(); }
+
+  void reserve(size_t n) {
+    x.reserve(n);
+    y.reserve(n);
+    vx.reserve(n);
+    vy.reserve(n);
+    flags.reserve(n);
+  }
+
+  void add(sf::Vector2f pos, sf::Vector2f vel) {
+    x.push_back(pos.x);
+    y.push_back(pos.y);
+    vx.push_back(vel.x);
+    vy.push_back(vel.y);
+    flags.push_back(0);
+  }
+
+  // Swaps the last asteroid into slot i.
+  void remove(size_t i) {
+    size_t last = size() - 1;
+    x[i] = x[last];
+    y[i] = y[last];
+    vx[i] = vx[last];
+    vy[i] = vy[last];
+    flags[i] = flags[last];
+    x.pop_back();
+    y.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+    flags.pop_back();
+  }
+
+  sf::Vector2f position(size_t i) const { return {x[i], y[i]}; }
+  sf::Vector2f velocity(size_t i) const { return {vx[i], vy[i]}; }
+  void setVelocity(size_t i, sf::Vector2f vel) {
+    vx[i] = vel.x;
+    vy[i] = vel.y;
+  }
+  bool hasFlag(size_t i, Flags flag) const { return flags[i] & flag; }
+  void setFlag(size_t i, Flags flag) { flags[i] |= flag; }
+
+  // Moves every asteroid by its velocity, clears Colided and marks as Far the
+  // ones ending up more than maxDistance away from center. Big fields are
+  // split over the pool.
+  void integrate(float dt, sf::Vector2f center, float maxDistance,
+                 ThreadPool &pool = ThreadPool::global()) {
+    float maxDistance2 = maxDistance * maxDistance;
+    pool.parallelFor(size(), IntegrateGrain, [&](size_t begin, size_t end) {
+      size_t done = begin;
+#if AMONG_THE_STARS_X86
+      if (simd::hasAvx2())
+        done = integrateAvx2(begin, end, dt, center, maxDistance2);
+      else if (simd::hasSse2())
+        done = integrateSse2(begin, end, dt, center, maxDistance2);
+#endif
+      integrateScalar(done, end, dt, center, maxDistance2);
+    });
+  }
+
+  // Calls f(i, j) for every pair whose axis-aligned boxes of the given extent
+  // (anchored at the position, like an unrotated sprite with its origin in
+  // the corner) overlap. Pairs come out in a fixed order for a given field.
+  //
+  // The asteroids are binned into cells of cellSize and their boxes packed
+  // cell after cell, so each asteroid is tested against a whole neighbouring
+  // cell at once, see PackedBounds.
+  template <typename F>
+  void forEachOverlap(float cellSize, sf::Vector2f extent, F &&f) {
+    bin(cellSize, extent);
+    static const int32_t forward[][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+    for (uint32_t c = 0; c < cells.size(); ++c) {
+      uint32_t first = cells[c].first, last = first + cells[c].count;
+      for (uint32_t i = first; i + 1 < last; ++i)
+        overlapRun(i, i + 1, last, f);
+      for (auto &offset : forward) {
+        uint32_t other = find(cells[c].x + offset[0], cells[c].y + offset[1]);
+        if (other == npos)
+          continue;
+        for (uint32_t i = first; i < last; ++i)
+          overlapRun(i, cells[other].first,
+                     cells[other].first + cells[other].count, f);
+      }
+    }
+  }
+
+  // Lowest index of an asteroid whose box overlaps `box`, size() if none.
+  // Only valid right after forEachOverlap, it reuses its cells.
+  size_t firstOverlap(const WorldBounds &box) {
+    const size_t query = sorted.size();
+    packed.set(query, box);
+    int32_t x0 = cellOf(box.left - binExtent.x), x1 = cellOf(box.right);
+    int32_t y0 = cellOf(box.top - binExtent.y), y1 = cellOf(box.bottom);
+    size_t found = size();
+    for (int32_t cy = y0; cy <= y1; ++cy)
+      for (int32_t cx = x0; cx <= x1; ++cx) {
+        uint32_t c = find(cx, cy);
+        if (c == npos)
+          continue;
+        uint32_t first = cells[c].first;
+        overlapRun(query, first, first + cells[c].count,
+                   [&](uint32_t, uint32_t i) {
+                     found = std::min<size_t>(found, i);
+                   });
+      }
+    return found;
+  }
+
+  std::vector<float> x, y, vx, vy;
+  std::vector<uint8_t> flags;
+
+private:
+  static const size_t IntegrateGrain = 16384; // asteroids per chunk
+
+  static constexpr uint32_t npos = ~0u;
+
+  // Cell of the broad phase, a run of `count` entries of `packed` and
+  // `sorted` starting at `first`.
+  struct Cell {
+    int32_t x, y;
+    uint32_t first, count;
+  };
+
+  int32_t cellOf(float v) const {
+    return static_cast<int32_t>(std::floor(v / binSize));
+  }
+
+  static uint64_t hash(int32_t cx, int32_t cy) {
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+                   static_cast<uint32_t>(cy);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+  }
+
+  uint32_t find(int32_t cx, int32_t cy) const {
+    size_t mask = table.size() - 1;
+    for (size_t i = hash(cx, cy) & mask; table[i]; i = (i + 1) & mask)
+      if (cells[table[i] - 1].x == cx && cells[table[i] - 1].y == cy)
+        return table[i] - 1;
+    return npos;
+  }
+
+  // Counting sort of the asteroids into cells, numbered in order of their
+  // first asteroid, then their boxes packed cell after cell. One slot past
+  // the asteroids is left for firstOverlap.
+  void bin(float cellSize, sf::Vector2f extent) {
+    const size_t n = size();
+    binSize = cellSize;
+    binExtent = extent;
+    size_t capacity = 64;
+    while (capacity < (n + 1) * 2)
+      capacity *= 2;
+    table.assign(capacity, 0);
+    cells.clear();
+    cellIndex.resize(n);
+    const size_t mask = capacity - 1;
+    for (size_t i = 0; i < n; ++i) {
+      int32_t cx = cellOf(x[i]), cy = cellOf(y[i]);
+      size_t slot = hash(cx, cy) & mask;
+      for (; table[slot]; slot = (slot + 1) & mask)
+        if (cells[table[slot] - 1].x == cx && cells[table[slot] - 1].y == cy)
+          break;
+      if (!table[slot]) {
+        cells.push_back({cx, cy, 0, 0});
+        table[slot] = static_cast<uint32_t>(cells.size());
+      }
+      cellIndex[i] = table[slot] - 1;
+      ++cells[cellIndex[i]].count;
+    }
+    uint32_t next = 0;
+    for (auto &cell : cells) {
+      cell.first = next;
+      next += cell.count;
+      cell.count = 0;
+    }
+    sorted.resize(n);
+    packed.resize(n + 1);
+    for (size_t i = 0; i < n; ++i) {
+      auto &cell = cells[cellIndex[i]];
+      uint32_t at = cell.first + cell.count++;
+      sorted[at] = static_cast<uint32_t>(i);
+      WorldBounds box;
+      box.left = x[i];
+      box.top = y[i];
+      box.right = x[i] + extent.x;
+      box.bottom = y[i] + extent.y;
+      packed.set(at, box);
+    }
+  }
+
+  // Calls f(sorted[one], sorted[k]) for every k in [begin, end) whose box
+  // overlaps the box of `one`, in order of k.
+  template <typename F>
+  void overlapRun(size_t one, uint32_t begin, uint32_t end, F &&f) {
+    overlapBits.resize((end - begin + 63) / 64);
+    packed.overlapMask(one, begin, end, overlapBits.data());
+    uint32_t self = one < sorted.size() ? sorted[one] : npos;
+    for (size_t w = 0; w < overlapBits.size(); ++w)
+      for (uint64_t bits = overlapBits[w]; bits; bits &= bits - 1)
+        f(self, sorted[begin + w * 64 + std::countr_zero(bits)]);
+  }
+
+  void integrateScalar(size_t begin, size_t end, float dt, sf::Vector2f center,
+                       float maxDistance2) {
+    for (size_t i = begin; i < end; ++i) {
+      x[i] += vx[i] * dt;
+      y[i] += vy[i] * dt;
+      float dx = x[i] - center.x, dy = y[i] - center.y;
+      flags[i] = dx * dx + dy * dy > maxDistance2 ? Far : 0;
+    }
+  }
+
+#if AMONG_THE_STARS_X86
+  AMONG_THE_STARS_AVX2 size_t integrateAvx2(size_t begin, size_t end, float dt,
+                                            sf::Vector2f center,
+                                            float maxDistance2) {
+    const size_t n = begin + (end - begin) / 8 * 8;
+    const __m256 vdt = _mm256_set1_ps(dt), cx = _mm256_set1_ps(center.x),
+                 cy = _mm256_set1_ps(center.y),
+                 limit = _mm256_set1_ps(maxDistance2);
+    for (size_t i = begin; i < n; i += 8) {
+      __m256 px = _mm256_add_ps(_mm256_loadu_ps(&x[i]),
+                                _mm256_mul_ps(_mm256_loadu_ps(&vx[i]), vdt));
+      __m256 py = _mm256_add_ps(_mm256_loadu_ps(&y[i]),
+                                _mm256_mul_ps(_mm256_loadu_ps(&vy[i]), vdt));
+      _mm256_storeu_ps(&x[i], px);
+      _mm256_storeu_ps(&y[i], py);
+      __m256 dx = _mm256_sub_ps(px, cx), dy = _mm256_sub_ps(py, cy);
+      __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+      int far = _mm256_movemask_ps(_mm256_cmp_ps(d2, limit, _CMP_GT_OQ));
+      for (int lane = 0; lane < 8; ++lane)
+        flags[i + lane] = (far >> lane) & 1 ? Far : 0;
+    }
+    return n;
+  }
+
+  AMONG_THE_STARS_SSE2 size_t integrateSse2(size_t begin, size_t end, float dt,
+                                            sf::Vector2f center,
+                                            float maxDistance2) {
+    const size_t n = begin + (end - begin) / 4 * 4;
+    const __m128 vdt = _mm_set1_ps(dt), cx = _mm_set1_ps(center.x),
+                 cy = _mm_set1_ps(center.y), limit = _mm_set1_ps(maxDistance2);
+    for (size_t i = begin; i < n; i += 4) {
+      __m128 px = _mm_add_ps(_mm_loadu_ps(&x[i]),
+                             _mm_mul_ps(_mm_loadu_ps(&vx[i]), vdt));
+      __m128 py = _mm_add_ps(_mm_loadu_ps(&y[i]),
+                             _mm_mul_ps(_mm_loadu_ps(&vy[i]), vdt));
+      _mm_storeu_ps(&x[i], px);
+      _mm_storeu_ps(&y[i], py);
+      __m128 dx = _mm_sub_ps(px, cx), dy = _mm_sub_ps(py, cy);
+      __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+      int far = _mm_movemask_ps(_mm_cmpgt_ps(d2, limit));
+      for (int lane = 0; lane < 4; ++lane)
+        flags[i + lane] = (far >> lane) & 1 ? Far : 0;
+    }
+    return n;
+  }
+#endif
+
+  // Broad phase, kept to avoid reallocating every tick.
+  float binSize = 1;
+  sf::Vector2f binExtent;
+  std::vector<Cell> cells;
+  std::vector<uint32_t> table;     // cell index + 1, 0 marks an empty slot
+  std::vector<uint32_t> cellIndex; // of every asteroid
+  std::vector<uint32_t> sorted;    // asteroid of every packed entry
+  PackedBounds packed;             // asteroid boxes by cell, then a query
+  std::vector<uint64_t> overlapBits;
+};
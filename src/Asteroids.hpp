@@ -0,0 +1,403 @@
+#pragma once
+#include "AsteroidField.hpp"
+#include "Player.hpp"
+#include "Random.hpp"
+#include "Sectors.hpp"
+#include "fmt/base.h"
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// Impulse for a bounce between two equal-mass asteroids, to be subtracted
+// from the first velocity and added to the second. Returns false when they
+// are already separating.
+inline bool bounceImpulse(sf::Vector2f pos1, sf::Vector2f vel1,
+                          sf::Vector2f pos2, sf::Vector2f vel2,
+                          sf::Vector2f &impulse) {
+  // Collision normal
+  sf::Vector2f collisionNormal = pos2 - pos1;
+  normalize(collisionNormal);
+
+  // Relative velocity
+  sf::Vector2f relativeVelocity = vel2 - vel1;
+
+  // Calculate velocity along the normal
+  float velocityAlongNormal = relativeVelocity.x * collisionNormal.x +
+                              relativeVelocity.y * collisionNormal.y;
+
+  // Ignore if velocities are separating
+  if (velocityAlongNormal > 0) {
+    return false;
+  }
+
+  // Coefficient of restitution (elasticity, range: 0.0 to 1.0)
+  float restitution = 0.8f;
+
+  // Impulse scalar
+  float impulseScalar = -(1.0f + restitution) * velocityAlongNormal;
+
+  // Assuming equal mass for simplicity
+  impulseScalar /= 2.0f;
+
+  // Impulse vector
+  impulse = impulseScalar * collisionNormal;
+  return true;
+}
+
+class Asteroid : public GameObject, public Movable, public Tickable {
+public:
+  static constexpr CollisionLayer Layer = CollisionLayer::Asteroid;
+
+  explicit Asteroid(Random &random)
+      : GameObject(texture(), {0, 0}, CollisionLayer::Asteroid) {
+    auto maxSpeed = 50;
+    auto x = random.uniform(maxSpeed);
+    auto xSign = random.uniform(2);
+    auto y = random.uniform(maxSpeed);
+    auto ySign = random.uniform(2);
+    x *= (xSign % 2 ? 1 : -1);
+    y *= (ySign % 2 ? 1 : -1);
+    // addAcc(x, y);
+    sprite.setScale(0.5, 0.5);
+    round = true;
+    auto max = 2048 * 4;
+    sf::Vector2f pos = {static_cast<float>(random.uniform(max)) - max / 2,
+                        static_cast<float>(random.uniform(max)) - max / 2};
+    if (std::abs(pos.x) < 150)
+      pos.x += xSign * 150;
+    if (std::abs(pos.y) < 150)
+      pos.y += ySign * 150;
+    setPos(pos.x, pos.y);
+  }
+  virtual void tick(float dt) override {
+    auto lastPos = getPos();
+    PhysicsTick(dt);
+    setPosition(getPos());
+    auto offset = getPos() - lastPos;
+    if (PlayerRef)
+      PlayerRef->setPos(offset.x + PlayerRef->getPos().x,
+                        offset.y + PlayerRef->getPos().y);
+    colided = false;
+  }
+
+  void onColision(Player &player, float dt) {
+    if (!isPlayerAttached)
+      if (intersects(player)) {
+        fmt::println("Player Found Asteroid, will die!!");
+        player.Kill();
+        PlayerRef = &player;
+        isPlayerAttached = true;
+      }
+  }
+
+  void onColision(Asteroid &asteroid, float dt) {
+    if (!colided && !asteroid.colided && intersects(asteroid)) {
+      sf::Vector2f impulse;
+      if (!bounceImpulse(getPos(), acc, asteroid.getPos(), asteroid.acc,
+                         impulse))
+        return;
+
+      // Apply impulse to both objects
+      acc -= impulse;
+      asteroid.addAcc(impulse);
+
+      // Mark as collided
+      colided = true;
+      asteroid.colided = true;
+    }
+  }
+  ~Asteroid() { isPlayerAttached = false; }
+
+  // Puts an asteroid taken from the pool back into play, as if new.
+  void respawn(sf::Vector2f pos, sf::Vector2f velocity) {
+    setPos(pos.x, pos.y);
+    acc = velocity;
+    PlayerRef = nullptr;
+    colided = false;
+  }
+  // Leaving play for the pool counts as being destroyed.
+  void despawn() {
+    PlayerRef = nullptr;
+    isPlayerAttached = false;
+  }
+  // Index in the pool, fixed for the whole level.
+  uint32_t getSlot() const { return slot; }
+
+  // Resolved once, spawning an asteroid does not look the path up again.
+  static TextureHandle texture() {
+    static const TextureHandle handle =
+        TextureProvider::load("./assets/asteroid.png");
+    return handle;
+  }
+
+private:
+  friend class Asteroids;
+  Player *PlayerRef = nullptr;
+  bool colided = false;
+  uint32_t slot = 0;
+  inline static bool isPlayerAttached = false;
+};
+
+// Asteroid objects are made up front, maxAsteroids of them, and recycled:
+// a despawned one goes back on the free list and the next spawn takes it
+// again, so the level does not allocate while the player flies around. A
+// field reserves room for as many.
+//
+// Asteroids leaving the area around the player are parked in Sectors, up to
+// `dormant` of them, and brought back into play when they come near again,
+// before any new one is spawned. Without room to park they are gone.
+class Asteroids : public Tickable {
+public:
+  struct PoolStats {
+    size_t capacity = 0;
+    size_t active = 0;
+    size_t highWater = 0; // most asteroids in play at once
+    uint64_t spawns = 0;
+    size_t dormant = 0;
+    uint64_t woken = 0; // dormant asteroids back in play
+  };
+
+  // With useField the asteroids live in an AsteroidField instead of being one
+  // Asteroid object each; they then collide among themselves and with the
+  // player (see setPlayer) in checkFieldCollisions rather than through
+  // checkCollisions.
+  Asteroids(std::weak_ptr<Movable> target, int maxAsteroids,
+            bool useField = false, Random random = Random(),
+            float cellSize = 200.0f, size_t dormant = 0)
+      : maxAsteroids(maxAsteroids), maxDistance(1000), target(target),
+        useField(useField), random(random), cellSize(cellSize),
+        sectors(maxDistance / 4.0f, dormant) {
+    // Resolved here even without a field, so spawning never packs a texture.
+    auto texture = Asteroid::texture();
+    fieldSprite.setTexture(TextureProvider::getTexture(texture));
+    fieldSprite.setScale(0.5, 0.5);
+    fieldSprite.setTextureRect(TextureProvider::getRect(texture));
+    auto size = TextureProvider::getSize(texture);
+    fieldExtent = {size.x * 0.5f, size.y * 0.5f};
+    stats.capacity = this->maxAsteroids;
+    if (useField) {
+      field.reserve(this->maxAsteroids);
+      return;
+    }
+    pool.reserve(this->maxAsteroids);
+    asteroids.reserve(this->maxAsteroids);
+    for (int i = 0; i < this->maxAsteroids; ++i) {
+      pool.push_back(std::make_shared<Asteroid>(this->random));
+      pool.back()->slot = static_cast<uint32_t>(i);
+      freeSlots.push_back(static_cast<uint32_t>(this->maxAsteroids - 1 - i));
+    }
+  }
+  virtual void tick(float df) override {
+    clock += df;
+    if (useField) {
+      tickField(df);
+      countActive();
+      return;
+    }
+    auto targetPos = target.lock()->getPos();
+    asteroids.erase(
+        std::remove_if(asteroids.begin(), asteroids.end(),
+                       [&](const std::shared_ptr<Asteroid> &asteroid) {
+                         if (PointLen(targetPos, asteroid->getPos()) <=
+                             maxDistance)
+                           return false;
+                         sectors.park(asteroid->getPos(), asteroid->getAcc(),
+                                      clock);
+                         asteroid->despawn();
+                         freeSlots.push_back(asteroid->slot);
+                         return true;
+                       }),
+        asteroids.end());
+    wakeDormant(targetPos, [this](sf::Vector2f pos, sf::Vector2f vel) {
+      if (freeSlots.empty())
+        return false;
+      auto &asteroid = pool[freeSlots.back()];
+      freeSlots.pop_back();
+      asteroid->respawn(pos, vel);
+      asteroids.push_back(asteroid);
+      return true;
+    });
+    if (asteroids.size() < maxAsteroids)
+      CreateAsteroids();
+    // An asteroid only moves itself, and the player if it is the one the
+    // player is stuck to.
+    ThreadPool::global().parallelFor(
+        asteroids.size(), TickGrain, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i)
+            asteroids[i]->tick(df);
+        });
+    countActive();
+  }
+  // Bounces field asteroids off each other and sticks the player to the
+  // first one it touches. World runs this with the other collision checks,
+  // after everything moved.
+  void checkFieldCollisions() {
+    if (!useField)
+      return;
+    auto s_player = player.lock();
+    field.forEachOverlap(cellSize, fieldExtent, [this](uint32_t a, uint32_t b) {
+      if (field.hasFlag(a, AsteroidField::Colided) ||
+          field.hasFlag(b, AsteroidField::Colided))
+        return;
+      sf::Vector2f impulse;
+      if (!bounceImpulse(field.position(a), field.velocity(a),
+                         field.position(b), field.velocity(b), impulse))
+        return;
+      field.setVelocity(a, field.velocity(a) - impulse);
+      field.setVelocity(b, field.velocity(b) + impulse);
+      field.setFlag(a, AsteroidField::Colided);
+      field.setFlag(b, AsteroidField::Colided);
+    });
+
+    if (s_player && attached == npos) {
+      size_t hit = field.firstOverlap(s_player->updateBounds());
+      if (hit < field.size()) {
+        fmt::println("Player Found Asteroid, will die!!");
+        s_player->Kill();
+        attached = hit;
+      }
+    }
+  }
+  const std::vector<std::shared_ptr<Asteroid>> &getAsteroids() const {
+    return asteroids;
+  }
+  const AsteroidField &getField() const { return field; }
+  const PoolStats &getPoolStats() const { return stats; }
+  // Looks like any asteroid, field or object, once positioned.
+  const sf::Sprite &getSprite() const { return fieldSprite; }
+
+  // The player the field asteroids can hit, only used with useField.
+  void setPlayer(std::weak_ptr<Player> player) { this->player = player; }
+
+protected:
+  void CreateAsteroids() {
+    int toCreate = maxAsteroids - size();
+    auto targetPos = target.lock()->getPos();
+    while (--toCreate) {
+      sf::Vector2f initialPos, velocity;
+      spawnParameters(targetPos, initialPos, velocity);
+      if (useField) {
+        field.add(initialPos, velocity);
+        ++stats.spawns;
+        continue;
+      }
+      if (freeSlots.empty())
+        break;
+      auto &asteroid = pool[freeSlots.back()];
+      freeSlots.pop_back();
+      asteroid->respawn(initialPos, velocity);
+      asteroids.push_back(asteroid);
+      ++stats.spawns;
+    }
+  }
+
+private:
+  size_t size() const { return useField ? field.size() : asteroids.size(); }
+
+  void countActive() {
+    stats.active = size();
+    stats.highWater = std::max(stats.highWater, stats.active);
+    stats.dormant = sectors.size();
+  }
+
+  // Brings back dormant asteroids a little inside the despawn distance, so
+  // one does not go back and forth on the border, while `take` has room.
+  template <typename F> void wakeDormant(sf::Vector2f targetPos, F &&take) {
+    sectors.wake(targetPos, maxDistance * 0.9f, clock,
+                 [this, &take](sf::Vector2f pos, sf::Vector2f vel) {
+                   if (!take(pos, vel))
+                     return false;
+                   ++stats.woken;
+                   return true;
+                 });
+    sectors.maintain(targetPos, clock);
+  }
+
+  void spawnParameters(sf::Vector2f targetPos, sf::Vector2f &initialPos,
+                       sf::Vector2f &velocity) {
+    // Random initial position for the asteroid, in range of the target so it
+    // is not despawned (or parked) straight away
+    auto around = [&] {
+      float x = static_cast<float>(random.uniform(2 * maxDistance));
+      float y = static_cast<float>(random.uniform(2 * maxDistance));
+      return targetPos + sf::Vector2f(x - maxDistance, y - maxDistance);
+    };
+    initialPos = around();
+
+    // Ensure the asteroid is placed outside a minimum radius from the target
+    while (PointLen(initialPos, targetPos) < 450.0f ||
+           PointLen(initialPos, targetPos) > maxDistance)
+      initialPos = around();
+
+    // Calculate direction vector towards the target
+    sf::Vector2f direction = targetPos - initialPos;
+
+    // Add randomness to the direction
+    direction.x += static_cast<float>(random.uniform(200) - 100) *
+                   0.1f; // Small random offset
+    direction.y += static_cast<float>(random.uniform(200) - 100) * 0.1f;
+
+    // Normalize and scale the direction vector to set velocity
+    normalize(direction);
+    float speed =
+        50.0f + static_cast<float>(
+                    random.uniform(50)); // Random speed between 50 and 100
+    velocity = direction * speed;
+  }
+
+  void tickField(float df) {
+    auto targetPos = target.lock()->getPos();
+    field.integrate(df, targetPos, maxDistance);
+
+    // Carry the player along with the asteroid it is stuck to.
+    auto s_player = player.lock();
+    if (attached != npos && s_player) {
+      auto offset = field.velocity(attached) * df;
+      s_player->setPos(offset.x + s_player->getPos().x,
+                       offset.y + s_player->getPos().y);
+    }
+
+    for (size_t i = 0; i < field.size();) {
+      if (!field.hasFlag(i, AsteroidField::Far)) {
+        ++i;
+        continue;
+      }
+      if (attached == i)
+        attached = npos;
+      else if (attached == field.size() - 1)
+        attached = i;
+      sectors.park(field.position(i), field.velocity(i), clock);
+      field.remove(i);
+    }
+    wakeDormant(targetPos, [this](sf::Vector2f pos, sf::Vector2f vel) {
+      if (field.size() >= static_cast<size_t>(maxAsteroids))
+        return false;
+      field.add(pos, vel);
+      return true;
+    });
+    if (field.size() < static_cast<size_t>(maxAsteroids))
+      CreateAsteroids();
+  }
+
+  static constexpr size_t npos = ~size_t(0);
+  static constexpr size_t TickGrain = 1024; // asteroids per tick chunk
+
+  int maxAsteroids = 10;
+  int maxDistance = 1000;
+  std::vector<std::shared_ptr<Asteroid>> asteroids; // in play
+  std::vector<std::shared_ptr<Asteroid>> pool;      // indexed by slot
+  std::vector<uint32_t> freeSlots;
+  PoolStats stats;
+  std::weak_ptr<Movable> target;
+  bool useField = false;
+  Random random; // spawn positions and velocities
+  float cellSize; // of the field's broad phase
+  AsteroidField field;
+  Sectors sectors; // asteroids out of range
+  double clock = 0; // seconds ticked, for the dormant asteroids
+  sf::Sprite fieldSprite;    // what WorldView stamps at every asteroid
+  sf::Vector2f fieldExtent;  // on-screen size of an asteroid
+  std::weak_ptr<Player> player;
+  size_t attached = npos;    // field asteroid the player is stuck to
+};
@@ -0,0 +1,484 @@
+#pragma once
+#include "GameObject.hpp"
+#include "Profiler.hpp"
+#include "Simd.hpp"
+#include "ThreadPool.hpp"
+#include "TileCache.hpp"
+#include "Utils.hpp"
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Stars per square pixel of sky, what used to be 1e6 stars on 16384x16384.
+const float STAR_DENSITY = 1e6f / (16384.0f * 16384.0f);
+
+// Unbounded starfield cut into square tiles. A tile is rendered the first
+// time the view touches it and kept in a least-recently-used cache of
+// maxTiles. Its stars come from a seed derived from the sky seed and the tile
+// coordinates, so a tile looks the same every time it is regenerated.
+//
+// Tiles are rasterized on the CPU into a pixel buffer, split across the
+// thread pool by rows, given a glow and uploaded to their texture in one go.
+// The glow is baked into the tile instead of being recomputed by a shader
+// every frame, the stars never change anyway. With a cache
+// directory, rendered tiles are also written to disk and later tiles are
+// loaded from there instead of being generated again.
+class Background : public Drawable {
+public:
+  // Stars of one tile as parallel arrays. Centers are whole pixels.
+  struct Stars {
+    std::vector<uint32_t> x, y, radius, brightness;
+  };
+
+  Background(float starDensity, uint64_t seed, int tileSize = 1024,
+             size_t maxTiles = 16, std::filesystem::path cacheDirectory = {})
+      : starDensity(starDensity), seed(seed), tileSize(tileSize),
+        maxTiles(maxTiles) {
+    PROFILE_SCOPE("Background");
+    if (!cacheDirectory.empty())
+      cache.emplace(std::move(cacheDirectory),
+                    TileCache::Key{GeneratorVersion,
+                                   static_cast<uint32_t>(tileSize),
+                                   static_cast<uint32_t>(starsPerTile()),
+                                   seed});
+  }
+
+  virtual void draw(sf::RenderWindow &rw) override {
+    auto &view = rw.getView();
+    auto viewSize = view.getSize();
+    sf::Vector2f cameraCenter = view.getCenter();
+
+    int left = tileIndex(cameraCenter.x - viewSize.x / 2);
+    int right = tileIndex(cameraCenter.x + viewSize.x / 2);
+    int top = tileIndex(cameraCenter.y - viewSize.y / 2);
+    int bottom = tileIndex(cameraCenter.y + viewSize.y / 2);
+    ++frame;
+    for (int ty = top; ty <= bottom; ++ty)
+      for (int tx = left; tx <= right; ++tx) {
+        rw.draw(acquire({tx, ty}).sprite);
+      }
+
+    // Shrink back after a view that needed more than maxTiles.
+    while (tiles.size() > maxTiles && tiles.back().lastFrame != frame) {
+      index.erase(tiles.back().coord);
+      tiles.pop_back();
+    }
+  }
+
+  // Tiles have to be wider than their star border and halve evenly for each
+  // bloom level.
+  static bool isValidTileSize(int size) {
+    return size > 2 * StarBorder && size % (1 << BloomLevels) == 0;
+  }
+
+  // Version of the star generator and rasterizer, part of the disk cache key.
+  static const uint32_t GeneratorVersion = 2;
+
+  // Seed of the stars in tile (tx, ty) of a sky.
+  static uint64_t tileSeed(uint64_t seed, sf::Vector2i tile) {
+    uint64_t z = seed ^ ((static_cast<uint64_t>(static_cast<uint32_t>(tile.x))
+                          << 32) |
+                         static_cast<uint32_t>(tile.y));
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  // Fills `stars` with `amount` stars for a size.x by size.y tile. Star i
+  // only depends on the seed and on i (counter-based hashing instead of a
+  // sequential generator), so the range is split over the pool, eight stars
+  // are generated at once where the CPU allows it and the result is the same
+  // on every path. Stars keep their whole outline inside `size` so tiles
+  // have no half stars along their borders.
+  static void generateStars(Stars &stars, int amount, sf::Vector2i size,
+                            uint64_t seed,
+                            ThreadPool &pool = ThreadPool::global()) {
+    const size_t n = static_cast<size_t>(std::max(amount, 0));
+    stars.x.resize(n);
+    stars.y.resize(n);
+    stars.radius.resize(n);
+    stars.brightness.resize(n);
+    const uint32_t key = static_cast<uint32_t>(seed ^ (seed >> 32));
+    const uint32_t rangeX = static_cast<uint32_t>(size.x - 2 * StarBorder);
+    const uint32_t rangeY = static_cast<uint32_t>(size.y - 2 * StarBorder);
+    pool.parallelFor(n, StarGrain, [&](size_t begin, size_t end) {
+      size_t i = begin;
+#if AMONG_THE_STARS_X86
+      if (simd::hasAvx2())
+        i = generateStarsAvx2(stars, begin, end, key, rangeX, rangeY);
+#endif
+      for (; i < end; ++i) {
+        uint32_t position = starHash(key, 2 * static_cast<uint32_t>(i));
+        uint32_t look = starHash(key, 2 * static_cast<uint32_t>(i) + 1);
+        stars.x[i] = StarBorder + (((position >> 16) * rangeX) >> 16);
+        stars.y[i] = StarBorder + (((position & 0xffff) * rangeY) >> 16);
+        stars.radius[i] = MinStarRadius + (((look >> 16) * 5) >> 16);
+        stars.brightness[i] = look & 0xff; // shades of white
+      }
+    });
+  }
+
+  // Draws `stars` over a black size.x by size.y buffer, one grey byte per
+  // pixel. Every thread of
+  // the pool owns a band of rows and stamps the part of each star that falls
+  // into it, in star order, so overlapping stars end up as if drawn one by
+  // one.
+  static void rasterize(const Stars &stars, sf::Vector2i size,
+                        uint8_t *pixels,
+                        ThreadPool &pool = ThreadPool::global()) {
+    const size_t rowBytes = static_cast<size_t>(size.x);
+    const size_t bands =
+        (static_cast<size_t>(size.y) + BandRows - 1) / BandRows;
+    pool.parallelFor(bands, 1, [&](size_t begin, size_t end) {
+      for (size_t band = begin; band < end; ++band) {
+        int top = static_cast<int>(band * BandRows);
+        int bottom = std::min(top + BandRows, size.y);
+        std::memset(pixels + top * rowBytes, 0, (bottom - top) * rowBytes);
+        for (size_t i = 0; i < stars.x.size(); ++i)
+          stamp(stars, i, top, bottom, pixels, rowBytes);
+      }
+    });
+  }
+
+  // Adds a glow to the extent x extent grey `canvas` and writes its inner
+  // size x size square, starting at (apron, apron), to `out`. The part of
+  // every pixel above BloomThreshold is box-filtered down BloomLevels times
+  // by two, then the levels are added back up from the coarsest one,
+  // upsampling bilinearly on the way, so bright stars get a soft halo about
+  // 2^BloomLevels pixels wide. The apron has to be wider than that for tiles
+  // to join without seams.
+  static void bloom(const uint8_t *canvas, int extent, int apron, int size,
+                    uint8_t *out, ThreadPool &pool = ThreadPool::global()) {
+    std::vector<Level> levels(BloomLevels + 1);
+    levels[0].size = extent;
+    levels[0].pixels.resize(static_cast<size_t>(extent) * extent);
+    for (size_t i = 0; i < levels[0].pixels.size(); ++i)
+      levels[0].pixels[i] = std::max(canvas[i] - BloomThreshold, 0);
+    for (int k = 1; k <= BloomLevels; ++k) {
+      const Level &src = levels[k - 1];
+      Level &dst = levels[k];
+      dst.size = (src.size + 1) / 2;
+      dst.pixels.resize(static_cast<size_t>(dst.size) * dst.size);
+      pool.parallelFor(dst.size, BandRows / 2, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y) {
+          int y0 = 2 * static_cast<int>(y), y1 = std::min(y0 + 1, src.size - 1);
+          for (int x = 0; x < dst.size; ++x) {
+            int x0 = 2 * x, x1 = std::min(x0 + 1, src.size - 1);
+            dst.pixels[y * dst.size + x] =
+                0.25f * (src.at(x0, y0) + src.at(x1, y0) + src.at(x0, y1) +
+                         src.at(x1, y1));
+          }
+        }
+      });
+    }
+
+    for (int k = BloomLevels - 1; k >= 1; --k) {
+      Level &dst = levels[k];
+      pool.parallelFor(dst.size, BandRows / 2, [&](size_t begin, size_t end) {
+        for (size_t y = begin; y < end; ++y)
+          for (int x = 0; x < dst.size; ++x)
+            dst.pixels[y * dst.size + x] +=
+                levels[k + 1].upsample(x, static_cast<int>(y));
+      });
+    }
+
+    pool.parallelFor(size, BandRows, [&](size_t begin, size_t end) {
+      for (size_t row = begin; row < end; ++row) {
+        int y = static_cast<int>(row) + apron;
+        for (int col = 0; col < size; ++col) {
+          int x = col + apron;
+          float value = canvas[y * extent + x] +
+                        BloomStrength * levels[1].upsample(x, y);
+          out[row * size + col] =
+              static_cast<uint8_t>(std::min(value + 0.5f, 255.0f));
+        }
+      }
+    });
+  }
+
+  // Generates the tile at `coord` into `grey`, tileSize x tileSize bytes,
+  // without going through the cache or the GPU.
+  void paintTile(sf::Vector2i coord, std::vector<uint8_t> &grey) {
+    grey.resize(static_cast<size_t>(tileSize) * tileSize);
+    paint(coord, grey.data());
+  }
+
+private:
+  static const int StarBorder = 8; // bigger than the largest outer radius
+  static const int MinStarRadius = 3;
+  static const int MaxStarRadius = 7;
+  static const int MaskSize = 2 * MaxStarRadius + 1;
+  static const int BandRows = 64;
+  static const size_t StarGrain = 8192; // stars per generateStars chunk
+  static const int BloomLevels = 4;
+  static const int BloomApron = 48; // wider than the halo of the last level
+  static const int BloomThreshold = 128; // dimmer stars do not glow
+  static constexpr float BloomStrength = 0.5f;
+
+  // One step of the bloom chain.
+  struct Level {
+    int size;
+    std::vector<float> pixels;
+
+    float at(int x, int y) const { return pixels[y * size + x]; }
+
+    // Bilinear sample for pixel (x, y) of the level twice as big. Pixel
+    // centers of the bigger level fall a quarter of a pixel away from ours.
+    float upsample(int x, int y) const {
+      auto taps = [this](int c, int &near, int &far) {
+        near = std::min(c / 2, size - 1);
+        far = std::clamp(c % 2 ? near + 1 : near - 1, 0, size - 1);
+      };
+      int nx, fx, ny, fy;
+      taps(x, nx, fx);
+      taps(y, ny, fy);
+      return 0.5625f * at(nx, ny) + 0.1875f * (at(fx, ny) + at(nx, fy)) +
+             0.0625f * at(fx, fy);
+    }
+  };
+
+  using StarMask = std::array<uint8_t, MaskSize * MaskSize>;
+
+  // lowbias32 by Chris Wellons, applied twice to mix the seed in.
+  static uint32_t mix(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+  }
+  static uint32_t starHash(uint32_t key, uint32_t counter) {
+    return mix(mix(counter) ^ key);
+  }
+
+#if AMONG_THE_STARS_X86
+  AMONG_THE_STARS_AVX2 static __m256i mix(__m256i x) {
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+    x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x846ca68bu));
+    x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+    return x;
+  }
+
+  // Generates stars [begin, end) eight at a time, returns where it stopped.
+  AMONG_THE_STARS_AVX2 static size_t
+  generateStarsAvx2(Stars &stars, size_t begin, size_t end, uint32_t key,
+                    uint32_t rangeX, uint32_t rangeY) {
+    const size_t n = begin + (end - begin) / 8 * 8;
+    const __m256i vkey = _mm256_set1_epi32(key),
+                  lanes = _mm256_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14),
+                  one = _mm256_set1_epi32(1),
+                  low16 = _mm256_set1_epi32(0xffff),
+                  vrangeX = _mm256_set1_epi32(rangeX),
+                  vrangeY = _mm256_set1_epi32(rangeY),
+                  border = _mm256_set1_epi32(StarBorder),
+                  minRadius = _mm256_set1_epi32(MinStarRadius),
+                  radii = _mm256_set1_epi32(5),
+                  shade = _mm256_set1_epi32(0xff);
+    for (size_t i = begin; i < n; i += 8) {
+      __m256i counter = _mm256_add_epi32(
+          _mm256_set1_epi32(static_cast<int>(2 * i)), lanes);
+      __m256i position = mix(_mm256_xor_si256(mix(counter), vkey));
+      __m256i look =
+          mix(_mm256_xor_si256(mix(_mm256_add_epi32(counter, one)), vkey));
+      __m256i x = _mm256_srli_epi32(
+          _mm256_mullo_epi32(_mm256_srli_epi32(position, 16), vrangeX), 16);
+      __m256i y = _mm256_srli_epi32(
+          _mm256_mullo_epi32(_mm256_and_si256(position, low16), vrangeY), 16);
+      __m256i radius = _mm256_srli_epi32(
+          _mm256_mullo_epi32(_mm256_srli_epi32(look, 16), radii), 16);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(&stars.x[i]),
+                          _mm256_add_epi32(x, border));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(&stars.y[i]),
+                          _mm256_add_epi32(y, border));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(&stars.radius[i]),
+                          _mm256_add_epi32(radius, minRadius));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(&stars.brightness[i]),
+                          _mm256_and_si256(look, shade));
+    }
+    return n;
+  }
+#endif
+
+  // Pixel coverage of a five-pointed star around a whole pixel center, for
+  // every outer radius. A pixel is covered when its center is inside the
+  // outline, like the rasterizer filling the old ConvexShape stars did.
+  static const std::array<StarMask, MaxStarRadius + 1> &starMasks() {
+    static const auto masks = [] {
+      std::array<StarMask, MaxStarRadius + 1> masks{};
+      const int points = 5;
+      const float angleStep = 2 * 3.14159265f / points;
+      for (int radius = MinStarRadius; radius <= MaxStarRadius; ++radius) {
+        float innerRadius = radius / 2.5f;
+        sf::Vector2f outline[points * 2];
+        for (int i = 0; i < points * 2; ++i) {
+          float radiusToUse = (i % 2 == 0) ? radius : innerRadius;
+          float angle = i * (angleStep / 2);
+          outline[i] = {std::cos(angle) * radiusToUse,
+                        std::sin(angle) * radiusToUse};
+        }
+        for (int my = 0; my < MaskSize; ++my)
+          for (int mx = 0; mx < MaskSize; ++mx) {
+            sf::Vector2f p(mx - MaxStarRadius + 0.5f,
+                           my - MaxStarRadius + 0.5f);
+            bool inside = false;
+            for (int i = 0, j = points * 2 - 1; i < points * 2; j = i++) {
+              auto &a = outline[i], &b = outline[j];
+              if ((a.y > p.y) != (b.y > p.y) &&
+                  p.x < (b.x - a.x) * (p.y - a.y) / (b.y - a.y) + a.x)
+                inside = !inside;
+            }
+            masks[radius][my * MaskSize + mx] = inside;
+          }
+      }
+      return masks;
+    }();
+    return masks;
+  }
+
+  // Writes the rows [top, bottom) of star i.
+  static void stamp(const Stars &stars, size_t i, int top, int bottom,
+                    uint8_t *pixels, size_t rowBytes) {
+    int cy = static_cast<int>(stars.y[i]);
+    int first = std::max(cy - MaxStarRadius, top);
+    int last = std::min(cy + MaxStarRadius + 1, bottom);
+    if (first >= last)
+      return;
+    const StarMask &mask = starMasks()[stars.radius[i]];
+    const uint8_t shade = static_cast<uint8_t>(stars.brightness[i]);
+    int left = static_cast<int>(stars.x[i]) - MaxStarRadius;
+    for (int row = first; row < last; ++row) {
+      const uint8_t *coverage = &mask[(row - cy + MaxStarRadius) * MaskSize];
+      uint8_t *pixel = pixels + row * rowBytes + left;
+      for (int mx = 0; mx < MaskSize; ++mx)
+        if (coverage[mx])
+          pixel[mx] = shade;
+    }
+  }
+
+  struct Tile {
+    sf::Vector2i coord;
+    std::unique_ptr<sf::Texture> texture;
+    sf::Sprite sprite;
+    uint64_t lastFrame = 0;
+  };
+
+  struct TileHash {
+    size_t operator()(const sf::Vector2i &tile) const {
+      return tileSeed(0, tile);
+    }
+  };
+
+  int starsPerTile() const {
+    return static_cast<int>(std::lround(starDensity * tileSize * tileSize));
+  }
+
+  int tileIndex(float coord) const {
+    return static_cast<int>(std::floor(coord / tileSize));
+  }
+
+  // Returns the tile, rendering it if it is not cached. The least recently
+  // drawn tile is recycled once the cache is full, unless it is still needed
+  // for the current frame (a view bigger than the cache).
+  Tile &acquire(sf::Vector2i coord) {
+    auto found = index.find(coord);
+    if (found != index.end()) {
+      tiles.splice(tiles.begin(), tiles, found->second);
+      found->second->lastFrame = frame;
+      return *found->second;
+    }
+
+    if (tiles.size() >= maxTiles && tiles.back().lastFrame != frame) {
+      index.erase(tiles.back().coord);
+      tiles.splice(tiles.begin(), tiles, std::prev(tiles.end()));
+    } else {
+      tiles.emplace_front();
+      tiles.front().texture = std::make_unique<sf::Texture>();
+      tiles.front().texture->create(tileSize, tileSize);
+    }
+    Tile &tile = tiles.front();
+    tile.coord = coord;
+    tile.lastFrame = frame;
+    render(tile);
+    index[coord] = tiles.begin();
+    return tile;
+  }
+
+  void render(Tile &tile) {
+    PROFILE_SCOPE("Background tile");
+    const size_t area = static_cast<size_t>(tileSize) * tileSize;
+    grey.resize(area);
+    if (!cache || !cache->load(tile.coord, grey)) {
+      paint(tile.coord, grey.data());
+      if (cache)
+        cache->store(tile.coord, grey);
+    }
+    pixels.resize(area * 4);
+    for (size_t i = 0; i < area; ++i) {
+      pixels[i * 4] = pixels[i * 4 + 1] = pixels[i * 4 + 2] = grey[i];
+      pixels[i * 4 + 3] = 255;
+    }
+    tile.texture->update(pixels.data());
+    tile.sprite.setTexture(*tile.texture, true);
+    tile.sprite.setPosition(static_cast<float>(tile.coord.x * tileSize),
+                            static_cast<float>(tile.coord.y * tileSize));
+  }
+
+  // Rasterizes the stars of a tile and of the apron around it, taken from
+  // the neighbouring tiles, and blooms them into `out`.
+  void paint(sf::Vector2i coord, uint8_t *out) {
+    PROFILE_SCOPE("Paint tile");
+    const int extent = tileSize + 2 * BloomApron;
+    stars.x.clear();
+    stars.y.clear();
+    stars.radius.clear();
+    stars.brightness.clear();
+    for (int dy = -1; dy <= 1; ++dy)
+      for (int dx = -1; dx <= 1; ++dx) {
+        generateStars(neighbour, starsPerTile(), {tileSize, tileSize},
+                      tileSeed(seed, coord + sf::Vector2i(dx, dy)));
+        for (size_t i = 0; i < neighbour.x.size(); ++i) {
+          int x = static_cast<int>(neighbour.x[i]) + dx * tileSize + BloomApron;
+          int y = static_cast<int>(neighbour.y[i]) + dy * tileSize + BloomApron;
+          if (x < MaxStarRadius || y < MaxStarRadius ||
+              x + MaxStarRadius >= extent || y + MaxStarRadius >= extent)
+            continue;
+          stars.x.push_back(x);
+          stars.y.push_back(y);
+          stars.radius.push_back(neighbour.radius[i]);
+          stars.brightness.push_back(neighbour.brightness[i]);
+        }
+      }
+    canvas.resize(static_cast<size_t>(extent) * extent);
+    rasterize(stars, {extent, extent}, canvas.data());
+    bloom(canvas.data(), extent, BloomApron, tileSize, out);
+  }
+
+  float starDensity;
+  uint64_t seed;
+  int tileSize;
+  size_t maxTiles;
+  uint64_t frame = 0;
+  std::list<Tile> tiles; // most recently used first
+  std::unordered_map<sf::Vector2i, std::list<Tile>::iterator, TileHash> index;
+  std::optional<TileCache> cache;
+  // Scratch of the tile being rendered.
+  Stars stars, neighbour;
+  std::vector<uint8_t> canvas; // grey, tile and apron
+  std::vector<uint8_t> grey;   // grey, tileSize x tileSize
+  std::vector<uint8_t> pixels; // RGBA, tileSize x tileSize
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include "GameObject.hpp"
+#include "Profiler.hpp"
+#include "SpatialGrid.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+// Collision handlers indexed by the layers of the two objects. Registering
+// (A, B) also covers (B, A), so dispatching a pair is a single lookup and
+// layer pairs without a handler can be dropped before the narrow phase.
+class CollisionMatrix {
+public:
+  // Registers A::*Handler(B &, float dt) for every A/B pair, e.g.
+  // add<Asteroid, Player, &Asteroid::onColision>().
+  template <typename A, typename B, void (A::*Handler)(B &, float)> void add() {
+    at(A::Layer, B::Layer) = {[](GameObject &a, GameObject &b, float dt) {
+      (static_cast<A &>(a).*Handler)(static_cast<B &>(b), dt);
+    }, false};
+    if (A::Layer != B::Layer)
+      at(B::Layer, A::Layer) = {at(A::Layer, B::Layer).handler, true};
+  }
+
+  bool handles(CollisionLayer a, CollisionLayer b) const {
+    return table[index(a, b)].handler != nullptr;
+  }
+
+  void dispatch(GameObject &a, GameObject &b, float dt) const {
+    auto &entry = table[index(a.getLayer(), b.getLayer())];
+    if (!entry.handler)
+      return;
+    if (entry.swapped)
+      entry.handler(b, a, dt);
+    else
+      entry.handler(a, b, dt);
+  }
+
+private:
+  using Handler = void (*)(GameObject &, GameObject &, float);
+  struct Entry {
+    Handler handler = nullptr;
+    bool swapped = false; // registered the other way round
+  };
+  static constexpr size_t Layers = static_cast<size_t>(CollisionLayer::Count);
+
+  static size_t index(CollisionLayer a, CollisionLayer b) {
+    return static_cast<size_t>(a) * Layers + static_cast<size_t>(b);
+  }
+  Entry &at(CollisionLayer a, CollisionLayer b) { return table[index(a, b)]; }
+
+  std::array<Entry, Layers * Layers> table{};
+};
+
+// Everything checkCollisions keeps between frames.
+struct CollisionState {
+  explicit CollisionState(int cellSize = 200) : grid(cellSize) {}
+
+  CollisionMatrix matrix;
+  struct Pair {
+    uint32_t a, b;
+  };
+
+  SpatialGrid grid;
+  std::vector<Pair> pairs;          // broad phase output
+  std::vector<uint32_t> pairWave;   // wave of each pair
+  std::vector<uint32_t> nextWave;   // per object, first wave it is free in
+  std::vector<uint32_t> waveStart;  // offsets of each wave in `scheduled`
+  std::vector<Pair> scheduled;      // pairs grouped by wave
+};
+
+// Below this many pairs a wave is resolved on the calling thread, waking the
+// workers would cost more than it saves.
+const size_t NARROW_PHASE_GRAIN = 256;
+
+// Broad phase through the persistent grid, which tests cached bounds a cell
+// at a time, keeping only overlapping pairs whose layers have a handler in
+// state.matrix. The handler then runs once per pair.
+//
+// The narrow phase is split into waves: a pair goes into the first wave after
+// the last one that touched either of its objects. Pairs in a wave share no
+// object and can run on any thread, while every object still sees its pairs
+// in broad phase order. The outcome is therefore bit-identical to resolving
+// the pairs one by one, whatever the number of threads.
+inline void
+checkCollisions(CollisionState &state,
+                const std::vector<std::shared_ptr<GameObject>> &objects,
+                float dt, ThreadPool &pool = ThreadPool::global()) {
+  auto &grid = state.grid;
+  {
+    PROFILE_SCOPE("Collision grid update");
+    grid.update(objects);
+  }
+
+  {
+    PROFILE_SCOPE("Collision pairs");
+    state.pairs.clear();
+    grid.forEachOverlap([&state, &grid](uint32_t a, uint32_t b) {
+      if (state.matrix.handles(grid.layer(a), grid.layer(b)))
+        state.pairs.push_back({a, b});
+    });
+
+    state.nextWave.assign(grid.size(), 0);
+    state.pairWave.resize(state.pairs.size());
+    state.waveStart.assign(1, 0);
+    for (size_t i = 0; i < state.pairs.size(); ++i) {
+      auto [a, b] = state.pairs[i];
+      uint32_t wave = std::max(state.nextWave[a], state.nextWave[b]);
+      state.nextWave[a] = state.nextWave[b] = wave + 1;
+      state.pairWave[i] = wave;
+      if (state.waveStart.size() < wave + 2)
+        state.waveStart.resize(wave + 2, 0);
+      state.waveStart[wave + 1]++;
+    }
+    for (size_t w = 1; w < state.waveStart.size(); ++w)
+      state.waveStart[w] += state.waveStart[w - 1];
+
+    // Stable counting sort, pairs keep their broad phase order inside a wave.
+    state.scheduled.resize(state.pairs.size());
+    state.nextWave.assign(state.waveStart.begin(), state.waveStart.end());
+    for (size_t i = 0; i < state.pairs.size(); ++i)
+      state.scheduled[state.nextWave[state.pairWave[i]]++] = state.pairs[i];
+  }
+
+  PROFILE_SCOPE("Collision narrow phase");
+  auto resolve = [&grid, &state, dt](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      state.matrix.dispatch(*grid.object(state.scheduled[i].a),
+                            *grid.object(state.scheduled[i].b), dt);
+    }
+  };
+  std::function<void(size_t, size_t)> body;
+  for (size_t w = 0; w + 1 < state.waveStart.size(); ++w) {
+    size_t begin = state.waveStart[w], count = state.waveStart[w + 1] - begin;
+    if (count <= NARROW_PHASE_GRAIN) {
+      resolve(begin, begin + count);
+      continue;
+    }
+    body = [&resolve, begin](size_t from, size_t to) {
+      resolve(begin + from, begin + to);
+    };
+    pool.parallelFor(count, NARROW_PHASE_GRAIN / 4, body);
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/View.hpp>
+#include <cstddef>
+
+// Sprites that went into the batch and sprites left out as off-screen.
+struct CullStats {
+  size_t drawn = 0;
+  size_t culled = 0;
+};
+
+// Area of the world `view` shows. The camera never rotates.
+inline sf::FloatRect viewRect(const sf::View &view) {
+  sf::Vector2f size = view.getSize();
+  sf::Vector2f topLeft = view.getCenter() - size / 2.0f;
+  return {topLeft.x, topLeft.y, size.x, size.y};
+}
+
+// Culls a sprite stamped at many positions against a view: the view is grown
+// by the sprite's bounds once, so each position only costs a point test.
+class StampCuller {
+public:
+  StampCuller(const sf::View &view, const sf::Sprite &stamp) {
+    sf::FloatRect area = viewRect(view);
+    sf::FloatRect bounds = stamp.getGlobalBounds();
+    sf::Vector2f offset = sf::Vector2f(bounds.left, bounds.top) -
+                          stamp.getPosition();
+    min = {area.left - offset.x - bounds.width,
+           area.top - offset.y - bounds.height};
+    max = {area.left + area.width - offset.x,
+           area.top + area.height - offset.y};
+  }
+
+  // Whether the sprite placed at `pos` overlaps the view, counted in stats.
+  bool keep(sf::Vector2f pos, CullStats &stats) const {
+    bool visible = pos.x > min.x && pos.x < max.x && pos.y > min.y &&
+                   pos.y < max.y;
+    ++(visible ? stats.drawn : stats.culled);
+    return visible;
+  }
+
+private:
+  sf::Vector2f min, max;
+};
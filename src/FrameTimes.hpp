@@ -0,0 +1,52 @@
+#pragma once
+#include "fmt/base.h"
+#include <algorithm>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <vector>
+
+// Duration of every frame of a run, for comparing the same replay across
+// builds: a summary on stdout and optionally one CSV row per frame.
+class FrameTimes {
+public:
+  void add(double milliseconds) { frames.push_back(milliseconds); }
+
+  size_t size() const { return frames.size(); }
+
+  double mean() const {
+    double total = 0;
+    for (double ms : frames)
+      total += ms;
+    return frames.empty() ? 0 : total / frames.size();
+  }
+
+  // Duration that a fraction q of the frames do not exceed.
+  double percentile(double q) const {
+    if (frames.empty())
+      return 0;
+    auto sorted = frames;
+    std::sort(sorted.begin(), sorted.end());
+    return sorted[static_cast<size_t>(q * (sorted.size() - 1))];
+  }
+
+  void report(const char *name) const {
+    if (frames.empty())
+      return;
+    fmt::println("{}: {} frames, mean {:.3f} ms, p50 {:.3f} ms, p99 {:.3f} ms, "
+                 "max {:.3f} ms",
+                 name, frames.size(), mean(), percentile(0.5),
+                 percentile(0.99), percentile(1));
+  }
+
+  bool write(const std::filesystem::path &path) const {
+    std::ofstream file(path, std::ios::trunc);
+    file << "frame,ms\n";
+    for (size_t i = 0; i < frames.size(); ++i)
+      file << fmt::format("{},{:.4f}\n", i, frames[i]);
+    return static_cast<bool>(file);
+  }
+
+private:
+  std::vector<double> frames;
+};
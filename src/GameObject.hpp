@@ -0,0 +1,162 @@
+#pragma once
+#include "SpriteBatch.hpp"
+#include "TextureProvider.hpp"
+#include "Utils.hpp"
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+class SpatialGrid;
+
+// What kind of object a GameObject is as far as collisions go. Handlers are
+// registered per pair of layers in a CollisionMatrix.
+enum class CollisionLayer : uint8_t {
+  None,
+  Player,
+  Spaceship,
+  Asteroid,
+  Count
+};
+
+// World space extent of a GameObject. A positive radius marks a round body,
+// two round bodies touch when their circles do, anything else is tested by
+// box.
+struct WorldBounds {
+  float left = 0, top = 0, right = 0, bottom = 0;
+  sf::Vector2f center;
+  float radius = 0;
+};
+
+inline bool overlaps(const WorldBounds &a, const WorldBounds &b) {
+  if (a.radius > 0 && b.radius > 0) {
+    sf::Vector2f d = a.center - b.center;
+    float reach = a.radius + b.radius;
+    return d.x * d.x + d.y * d.y < reach * reach;
+  }
+  return a.left < b.right && b.left < a.right && a.top < b.bottom &&
+         b.top < a.bottom;
+}
+
+class Drawable {
+public:
+  virtual void draw(sf::RenderWindow &rw) = 0;
+
+  // Draws through a batch shared by everything drawn this frame. Drawables
+  // that do not know about batching flush what came before and draw
+  // themselves directly.
+  virtual void drawBatched(sf::RenderWindow &rw, SpriteBatch &batch) {
+    batch.flush(rw);
+    draw(rw);
+  }
+};
+
+class GameObject : public Drawable {
+public:
+  GameObject(TextureHandle texture, sf::Vector2f pos,
+             CollisionLayer layer = CollisionLayer::None)
+      : sprite(TextureProvider::getTexture(texture)),
+        textureRect(TextureProvider::getRect(texture)),
+        textureSize(TextureProvider::getSize(texture)), layer(layer) {
+    sprite.setTextureRect(textureRect);
+    sprite.setPosition(pos);
+  }
+  GameObject(const std::filesystem::path &texture, sf::Vector2f pos,
+             CollisionLayer layer = CollisionLayer::None)
+      : GameObject(TextureProvider::load(texture), pos, layer) {}
+
+  // `rec` is relative to the object's image, not to the atlas page.
+  void setDefaultRect(sf::IntRect rec) {
+    sprite.setTextureRect({textureRect.left + rec.left,
+                           textureRect.top + rec.top, rec.width, rec.height});
+    sprite.setOrigin({static_cast<float>(rec.width) / 2.0f,
+                      static_cast<float>(rec.height) / 2.0f});
+  }
+
+  // Recomputes the cached bounds from the sprite. The collision grid does
+  // this once per tick for everything it holds.
+  const WorldBounds &updateBounds() {
+    auto box = sprite.getGlobalBounds();
+    bounds.left = box.left;
+    bounds.top = box.top;
+    bounds.right = box.left + box.width;
+    bounds.bottom = box.top + box.height;
+    bounds.center = {box.left + box.width / 2.0f, box.top + box.height / 2.0f};
+    bounds.radius = round ? std::min(box.width, box.height) / 2.0f : 0.0f;
+    return bounds;
+  }
+  const WorldBounds &getBounds() const { return bounds; }
+
+  // Tests the bounds cached by the last collision pass, not the sprites.
+  bool intersects(const GameObject &go) const {
+    return overlaps(bounds, go.bounds);
+  }
+
+  virtual void draw(sf::RenderWindow &rw) override { rw.draw(sprite); }
+  // Objects drawing more than their sprite override both.
+  virtual void drawBatched(sf::RenderWindow &rw, SpriteBatch &batch) override {
+    batch.add(sprite);
+  }
+
+  void setPosition(sf::Vector2f pos) { sprite.setPosition(pos); }
+
+  const sf::Sprite &getSprite() const { return sprite; }
+  CollisionLayer getLayer() const { return layer; }
+
+protected:
+  sf::Sprite sprite;
+  sf::IntRect textureRect; // the image inside its atlas page
+  sf::Vector2u textureSize;
+  CollisionLayer layer;
+  bool round = false; // collides as the circle inside its bounds
+
+private:
+  friend class SpatialGrid;
+  uint32_t gridHandle = ~0u; // slot in the SpatialGrid holding this object
+  WorldBounds bounds;
+};
+
+struct inputs {
+  bool W = false;
+  bool S = false;
+  bool A = false;
+  bool D = false;
+  bool SPACE = false;
+};
+
+class Tickable {
+public:
+  virtual void tick(float dt) = 0;
+  virtual void tick(float dt, const inputs &input) { tick(dt); }
+};
+
+class Movable {
+public:
+  Movable() = default;
+  void setPos(float x, float y) {
+    pos.x = x;
+    pos.y = y;
+  }
+  void addAcc(float x, float y) {
+    acc.x += x;
+    acc.y += y;
+  }
+  void addAcc(sf::Vector2f app) { acc += app; }
+  void PhysicsTick(float dt, float maxSpeed = 0) {
+    if (maxSpeed != 0)
+      if (VecLength(acc) > maxSpeed)
+        normalize(acc) *= maxSpeed;
+    pos += acc * dt;
+  }
+
+  const sf::Vector2f getInverseAcc() const { return -acc; }
+  const sf::Vector2f &getAcc() const { return acc; }
+  const sf::Vector2f &getPos() const { return pos; }
+
+protected:
+  sf::Vector2f pos;
+  sf::Vector2f acc = {0, 0};
+};
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define AMONG_THE_STARS_MMAP 1
+#else
+#define AMONG_THE_STARS_MMAP 0
+#endif
+
+// Read-only view of a whole file. Memory-mapped where the platform has mmap,
+// read into memory otherwise. Evaluates to false if the file could not be
+// opened.
+class MappedFile {
+public:
+  explicit MappedFile(const std::filesystem::path &path) {
+#if AMONG_THE_STARS_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    struct stat info;
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+      void *mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapped != MAP_FAILED) {
+        bytes = static_cast<const uint8_t *>(mapped);
+        length = static_cast<size_t>(info.st_size);
+      }
+    }
+    ::close(fd);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+      return;
+    buffer.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    if (file.read(reinterpret_cast<char *>(buffer.data()), buffer.size())) {
+      bytes = buffer.data();
+      length = buffer.size();
+    }
+#endif
+  }
+
+  ~MappedFile() {
+#if AMONG_THE_STARS_MMAP
+    if (bytes)
+      ::munmap(const_cast<uint8_t *>(bytes), length);
+#endif
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  explicit operator bool() const { return bytes != nullptr; }
+  const uint8_t *data() const { return bytes; }
+  size_t size() const { return length; }
+
+private:
+  const uint8_t *bytes = nullptr;
+  size_t length = 0;
+#if !AMONG_THE_STARS_MMAP
+  std::vector<uint8_t> buffer;
+#endif
+};
@@ -0,0 +1,138 @@
+#pragma once
+#include "GameObject.hpp"
+#include "Simd.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// WorldBounds of many objects as parallel arrays. Testing one object against
+// a run of others reads the run straight from the arrays, eight or four at a
+// time where the CPU allows it.
+class PackedBounds {
+public:
+  size_t size() const { return left.size(); }
+
+  void resize(size_t n) {
+    left.resize(n);
+    top.resize(n);
+    right.resize(n);
+    bottom.resize(n);
+    cx.resize(n);
+    cy.resize(n);
+    radius.resize(n);
+  }
+
+  void set(size_t i, const WorldBounds &b) {
+    left[i] = b.left;
+    top[i] = b.top;
+    right[i] = b.right;
+    bottom[i] = b.bottom;
+    cx[i] = b.center.x;
+    cy[i] = b.center.y;
+    radius[i] = b.radius;
+  }
+
+  // Sets bit k of `mask` (64 per word, ceil((end - begin) / 64) words) when
+  // object `one` overlaps object begin + k, exactly as overlaps() would say,
+  // and clears it otherwise.
+  void overlapMask(size_t one, size_t begin, size_t end,
+                   uint64_t *mask) const {
+    for (size_t w = 0; w < (end - begin + 63) / 64; ++w)
+      mask[w] = 0;
+    size_t done = begin;
+#if AMONG_THE_STARS_X86
+    if (simd::hasAvx2())
+      done = overlapAvx2(one, begin, end, mask);
+    else if (simd::hasSse2())
+      done = overlapSse2(one, begin, end, mask);
+#endif
+    overlapScalar(one, begin, done, end, mask);
+  }
+
+private:
+  void overlapScalar(size_t p, size_t begin, size_t from, size_t end,
+                     uint64_t *mask) const {
+    for (size_t q = from; q < end; ++q) {
+      bool hit;
+      if (radius[p] > 0 && radius[q] > 0) {
+        float dx = cx[p] - cx[q], dy = cy[p] - cy[q];
+        float reach = radius[p] + radius[q];
+        hit = dx * dx + dy * dy < reach * reach;
+      } else {
+        hit = left[p] < right[q] && left[q] < right[p] && top[p] < bottom[q] &&
+              top[q] < bottom[p];
+      }
+      size_t k = q - begin;
+      mask[k / 64] |= static_cast<uint64_t>(hit) << (k % 64);
+    }
+  }
+
+#if AMONG_THE_STARS_X86
+  AMONG_THE_STARS_AVX2 size_t overlapAvx2(size_t p, size_t begin, size_t end,
+                                          uint64_t *mask) const {
+    const size_t n = begin + (end - begin) / 8 * 8;
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 pl = _mm256_set1_ps(left[p]), pt = _mm256_set1_ps(top[p]),
+                 pr = _mm256_set1_ps(right[p]),
+                 pb = _mm256_set1_ps(bottom[p]), px = _mm256_set1_ps(cx[p]),
+                 py = _mm256_set1_ps(cy[p]), rp = _mm256_set1_ps(radius[p]);
+    const __m256 pRound = _mm256_cmp_ps(rp, zero, _CMP_GT_OQ);
+    for (size_t q = begin; q < n; q += 8) {
+      __m256 box = _mm256_and_ps(
+          _mm256_and_ps(
+              _mm256_cmp_ps(pl, _mm256_loadu_ps(&right[q]), _CMP_LT_OQ),
+              _mm256_cmp_ps(_mm256_loadu_ps(&left[q]), pr, _CMP_LT_OQ)),
+          _mm256_and_ps(
+              _mm256_cmp_ps(pt, _mm256_loadu_ps(&bottom[q]), _CMP_LT_OQ),
+              _mm256_cmp_ps(_mm256_loadu_ps(&top[q]), pb, _CMP_LT_OQ)));
+      __m256 rq = _mm256_loadu_ps(&radius[q]);
+      __m256 dx = _mm256_sub_ps(px, _mm256_loadu_ps(&cx[q]));
+      __m256 dy = _mm256_sub_ps(py, _mm256_loadu_ps(&cy[q]));
+      __m256 reach = _mm256_add_ps(rp, rq);
+      __m256 circle = _mm256_cmp_ps(
+          _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+          _mm256_mul_ps(reach, reach), _CMP_LT_OQ);
+      __m256 round =
+          _mm256_and_ps(pRound, _mm256_cmp_ps(rq, zero, _CMP_GT_OQ));
+      int hits = _mm256_movemask_ps(_mm256_blendv_ps(box, circle, round));
+      size_t k = q - begin;
+      mask[k / 64] |= static_cast<uint64_t>(hits) << (k % 64);
+    }
+    return n;
+  }
+
+  AMONG_THE_STARS_SSE2 size_t overlapSse2(size_t p, size_t begin, size_t end,
+                                          uint64_t *mask) const {
+    const size_t n = begin + (end - begin) / 4 * 4;
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 pl = _mm_set1_ps(left[p]), pt = _mm_set1_ps(top[p]),
+                 pr = _mm_set1_ps(right[p]), pb = _mm_set1_ps(bottom[p]),
+                 px = _mm_set1_ps(cx[p]), py = _mm_set1_ps(cy[p]),
+                 rp = _mm_set1_ps(radius[p]);
+    const __m128 pRound = _mm_cmpgt_ps(rp, zero);
+    for (size_t q = begin; q < n; q += 4) {
+      __m128 box = _mm_and_ps(
+          _mm_and_ps(_mm_cmplt_ps(pl, _mm_loadu_ps(&right[q])),
+                     _mm_cmplt_ps(_mm_loadu_ps(&left[q]), pr)),
+          _mm_and_ps(_mm_cmplt_ps(pt, _mm_loadu_ps(&bottom[q])),
+                     _mm_cmplt_ps(_mm_loadu_ps(&top[q]), pb)));
+      __m128 rq = _mm_loadu_ps(&radius[q]);
+      __m128 dx = _mm_sub_ps(px, _mm_loadu_ps(&cx[q]));
+      __m128 dy = _mm_sub_ps(py, _mm_loadu_ps(&cy[q]));
+      __m128 reach = _mm_add_ps(rp, rq);
+      __m128 circle =
+          _mm_cmplt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                       _mm_mul_ps(reach, reach));
+      __m128 round = _mm_and_ps(pRound, _mm_cmpgt_ps(rq, zero));
+      __m128 hit =
+          _mm_or_ps(_mm_and_ps(round, circle), _mm_andnot_ps(round, box));
+      int hits = _mm_movemask_ps(hit);
+      size_t k = q - begin;
+      mask[k / 64] |= static_cast<uint64_t>(hits) << (k % 64);
+    }
+    return n;
+  }
+#endif
+
+  std::vector<float> left, top, right, bottom, cx, cy, radius;
+};
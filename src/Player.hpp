@@ -0,0 +1,107 @@
+#pragma once
+#include "GameObject.hpp"
+#include "fmt/base.h"
+#include <chrono>
+#include <fmt/format.h>
+
+inline float PlayerGameScore = 0;
+
+// What the HUD shows about the player.
+struct PlayerStatus {
+  float fuel = 0;
+  float oxygen = 0;
+  float score = 0;
+  float onShip = 0; // seconds spent boarding the ship
+  bool dead = false;
+};
+
+class Player : public GameObject, public Movable, public Tickable {
+public:
+  static constexpr CollisionLayer Layer = CollisionLayer::Player;
+
+  Player(std::filesystem::path texture, sf::Vector2f pos)
+      : GameObject(texture, pos, CollisionLayer::Player) {
+    setPos(pos.x, pos.y);
+    setDefaultRect({0, 0, 52, 89});
+    sprite.scale(0.5, 0.5);
+  }
+  void Kill() {
+    using namespace std::literals;
+    if (creationTime - std::chrono::system_clock::now() > 15s)
+      return;
+    dead = true;
+    fuel = 0;
+    oxygen = 0;
+    addAcc(getInverseAcc());
+  }
+
+  bool isDead() { return oxygen <= 0; }
+  bool isWon() { return dtShip > 30; }
+
+  void addResources(float fuel, float oxygen) {
+    if (dead)
+      return;
+    this->fuel += fuel;
+    this->oxygen += oxygen;
+    if (this->fuel > 100.f)
+      this->fuel = 100;
+    if (this->oxygen > 100.f)
+      this->oxygen = 100;
+  }
+
+  virtual void tick(float dt) override {
+    PhysicsTick(dt, maxSpeed);
+    oxygen -= dt * 1;
+    if (fuel == 0)
+      oxygen -= dt * 4;
+    if (oxygen <= 0)
+      oxygen = 0;
+    setPosition(getPos());
+  }
+
+  virtual void tick(float dt, const inputs &input) override {
+    if (dtShip > 30)
+      fmt::println("Player WON!");
+
+    tick(dt);
+    points = fuel * 0.2f + oxygen * 0.5f;
+    if (oxygen == 0)
+      return;
+    sf::Vector2f accAppend = {0, 0};
+    if (input.W)
+      accAppend.y -= accTickSpeed * dt;
+    if (input.S)
+      accAppend.y += accTickSpeed * dt;
+    if (input.D)
+      accAppend.x += accTickSpeed * dt;
+    if (input.A)
+      accAppend.x -= accTickSpeed * dt;
+    if (input.SPACE)
+      accAppend = getInverseAcc() * dt;
+    if (VecLength(accAppend) != 0 && fuel != 0)
+      fuel -= 5.f * dt;
+
+    if (fuel <= 0) {
+      accAppend = {0, 0};
+      fuel = 0;
+    }
+    addAcc(accAppend);
+  }
+  void updatePlayerGlobalScore() { PlayerGameScore += points; }
+  void updateTimer(float dt) { dtShip += dt; }
+  void zeroPlayerTimer() { dtShip = 0; }
+  PlayerStatus status() const {
+    return {fuel, oxygen, points + PlayerGameScore, dtShip, dead};
+  }
+
+protected:
+  bool dead = false;
+  float maxSpeed = 500.f;
+  float accTickSpeed = 100.f;
+  float fuel = 100.f;
+  float oxygen = 100.0f;
+  float points = 0;
+  float dtShip = 0.0f;
+  std::chrono::time_point<std::chrono::system_clock> creationTime =
+      std::chrono::system_clock::now();
+};
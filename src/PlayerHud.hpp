@@ -0,0 +1,72 @@
+#pragma once
+#include "Player.hpp"
+#include "UI.hpp"
+
+// The player's HUD and the arrow pointing at the ship. Lives on the render
+// side and is fed with copied values, the Player itself only simulates.
+class PlayerHud {
+public:
+  PlayerHud()
+      : Position("X: {:.0f}, Y: {:.0f}"),
+        Acceleration("X: {:.2f} m/s2, Y: {:.2f} m/s2"), Points("Score: {:.0f}"),
+        PlayerShipStatus("Boarding fly around the ship for {:.0f}", 32, true) {
+    oxygenSlider.setFillColor(sf::Color::Blue);
+    oxygenSlider.setBackgroundColor(sf::Color(115, 115, 115));
+    fuelSlider.setFillColor(sf::Color::Yellow);
+    fuelSlider.setBackgroundColor(sf::Color(115, 115, 115));
+    hud.add(oxygenSlider);
+    hud.add(fuelSlider);
+    hud.add(Position);
+    hud.add(Acceleration);
+    hud.add(Points);
+    hud.add(PlayerShipStatus);
+  }
+
+  void update(sf::Vector2f pos, sf::Vector2f velocity, sf::Vector2f ship,
+              const PlayerStatus &status, float dt) {
+    this->pos = pos;
+    this->ship = ship;
+    dead = status.dead;
+    arrow.aim(pos, ship);
+    if (hud.setSize({VP_WIDTH, VP_HEIGHT}))
+      layout();
+    if (!hud.due(dt))
+      return;
+    Position.set(pos.x, pos.y);
+    Acceleration.set(velocity.x, velocity.y);
+    Points.set(status.score);
+    PlayerShipStatus.set(30.0f - status.onShip);
+    PlayerShipStatus.setVisible(status.onShip > 0);
+    oxygenSlider.set(status.oxygen);
+    fuelSlider.set(status.fuel);
+  }
+
+  void draw(sf::RenderWindow &rw) {
+    if (dead)
+      return;
+    hud.draw(rw, pos);
+    if (PointLen(pos, ship) > 200.0f)
+      arrow.draw(rw);
+  }
+
+private:
+  // HUD offsets are relative to the player, they only change with the
+  // viewport.
+  void layout() {
+    auto offsetRight = VP_WIDTH / 2.0f;
+    auto offsetBottom = VP_HEIGHT / 2.0f;
+    oxygenSlider.setOffset({-offsetRight + MARGIN, offsetBottom - 32});
+    fuelSlider.setOffset({offsetRight - 256 - MARGIN, offsetBottom - 32});
+    Points.setOffset({-offsetRight, -offsetBottom});
+    PlayerShipStatus.setOffset({0, -VP_HEIGHT / 4});
+    Position.setOffset({50, 0});
+    Acceleration.setOffset({50, 12});
+  }
+
+  HudText Position, Acceleration, Points, PlayerShipStatus;
+  HudBar oxygenSlider, fuelSlider;
+  Hud hud;
+  Arrow arrow;
+  sf::Vector2f pos, ship;
+  bool dead = false;
+};
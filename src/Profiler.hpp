@@ -0,0 +1,125 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fmt/format.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Scoped timers, see PROFILE_SCOPE. Every thread records into its own ring
+// buffer, which only that thread writes, so recording takes no lock. The
+// rings keep the last RingSize scopes of each thread; readers (the overlay,
+// the Chrome trace export) may see a slot being overwritten when a ring
+// wraps while they read it. Nothing is recorded while disabled.
+class Profiler {
+public:
+  struct Event {
+    const char *name; // a string literal, events only keep the pointer
+    int64_t start;    // ns since the profiler started
+    int64_t duration; // ns
+  };
+
+  static void setEnabled(bool enabled) { Profiler::enabled = enabled; }
+  static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+  static int64_t now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - epoch)
+        .count();
+  }
+
+  static void record(const char *name, int64_t start, int64_t end) {
+    Ring &ring = local();
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    ring.events[head % RingSize] = {name, start, end - start};
+    ring.head.store(head + 1, std::memory_order_release);
+  }
+
+  // Calls f(thread, event) for every recorded event that started at or after
+  // `since`. Threads are numbered in the order they first recorded.
+  template <typename F> static void forEachEvent(int64_t since, F &&f) {
+    std::lock_guard lock(registryMutex);
+    for (auto &ring : rings) {
+      uint64_t head = ring->head.load(std::memory_order_acquire);
+      uint64_t first = head > RingSize ? head - RingSize : 0;
+      for (uint64_t i = first; i < head; ++i) {
+        const Event &event = ring->events[i % RingSize];
+        if (event.start >= since)
+          f(ring->thread, event);
+      }
+    }
+  }
+
+  // Writes every recorded event as a Chrome trace (chrome://tracing,
+  // Perfetto). Returns false if the file could not be written.
+  static bool writeChromeTrace(const std::filesystem::path &path) {
+    std::unique_ptr<std::FILE, int (*)(std::FILE *)> file(
+        std::fopen(path.string().c_str(), "w"), &std::fclose);
+    if (!file)
+      return false;
+    fmt::print(file.get(), "{{\"traceEvents\":[");
+    bool first = true;
+    forEachEvent(0, [&](uint32_t thread, const Event &event) {
+      fmt::print(file.get(),
+                 "{}\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},"
+                 "\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                 first ? "" : ",", event.name, thread, event.start / 1e3,
+                 event.duration / 1e3);
+      first = false;
+    });
+    fmt::print(file.get(), "\n]}}\n");
+    return std::ferror(file.get()) == 0;
+  }
+
+private:
+  static const size_t RingSize = 1 << 15;
+
+  struct Ring {
+    uint32_t thread;
+    std::array<Event, RingSize> events;
+    std::atomic<uint64_t> head = 0;
+  };
+
+  // Rings are owned by the registry so they outlive their threads.
+  static Ring &local() {
+    thread_local Ring *ring = [] {
+      std::lock_guard lock(registryMutex);
+      rings.push_back(std::make_unique<Ring>());
+      rings.back()->thread = static_cast<uint32_t>(rings.size() - 1);
+      return rings.back().get();
+    }();
+    return *ring;
+  }
+
+  inline static std::atomic<bool> enabled = false;
+  inline static std::mutex registryMutex;
+  inline static std::vector<std::unique_ptr<Ring>> rings;
+};
+
+// Records the time from its construction to the end of the scope.
+class ProfileScope {
+public:
+  explicit ProfileScope(const char *name)
+      : name(name), start(Profiler::isEnabled() ? Profiler::now() : -1) {}
+  ~ProfileScope() {
+    if (start >= 0)
+      Profiler::record(name, start, Profiler::now());
+  }
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope &operator=(const ProfileScope &) = delete;
+
+private:
+  const char *name;
+  int64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)                                                    \
+  ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+// Counter-based generator: the n-th number of a stream is a hash of the
+// stream's key and n, like the stars of Background. Streams split off by id
+// (a subsystem, a level, a thread) are independent of each other and of how
+// much the others were used, so a whole world replays from one seed. A
+// Random is not shared between threads, split one off per thread instead.
+class Random {
+public:
+  explicit Random(uint64_t seed = 0) : key(mix(seed)) {}
+
+  Random split(uint64_t stream) const {
+    Random child;
+    child.key = mix(key ^ mix(stream + Golden));
+    return child;
+  }
+
+  uint64_t next() { return mix(key + ++counter * Golden); }
+
+  // In [0, n).
+  int uniform(int n) {
+    return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(n)) >> 32);
+  }
+
+  // In [min, max).
+  float uniform(float min, float max) {
+    return min + static_cast<float>(next() >> 40) * 0x1p-24f * (max - min);
+  }
+
+private:
+  static constexpr uint64_t Golden = 0x9e3779b97f4a7c15ULL;
+
+  // splitmix64 finalizer
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  uint64_t key = 0;
+  uint64_t counter = 0;
+};
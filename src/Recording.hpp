@@ -0,0 +1,93 @@
+#pragma once
+#include "MappedFile.hpp"
+#include "World.hpp"
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+// The inputs of every tick of a level, with everything needed to build the
+// same level again: seed, level, tick rate and world options. Played back
+// through a fixed timestep it retraces the recorded run exactly. Stored as a
+// header followed by one byte per tick.
+class Recording {
+public:
+  int level = 0;
+  float tickRate = 60.0f;
+  WorldOptions options;
+
+  void add(const inputs &input) {
+    ticks.push_back(input.W | input.S << 1 | input.A << 2 | input.D << 3 |
+                    input.SPACE << 4);
+  }
+
+  size_t size() const { return ticks.size(); }
+
+  inputs at(size_t tick) const {
+    uint8_t keys = ticks[tick];
+    inputs input;
+    input.W = keys & 1;
+    input.S = keys & 2;
+    input.A = keys & 4;
+    input.D = keys & 8;
+    input.SPACE = keys & 16;
+    return input;
+  }
+
+  bool save(const std::filesystem::path &path) const {
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.level = level;
+    header.tickRate = tickRate;
+    header.asteroidField = options.asteroidField;
+    header.dormantAsteroids = options.dormantAsteroids;
+    header.maxAsteroids = options.maxAsteroids;
+    header.gridSize = options.gridSize;
+    header.seed = options.seed;
+    header.ticks = ticks.size();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(ticks.data()), ticks.size());
+    return static_cast<bool>(file);
+  }
+
+  // Returns false if `path` is missing or not a recording.
+  bool load(const std::filesystem::path &path) {
+    MappedFile file(path);
+    Header header;
+    if (!file || file.size() < sizeof(Header))
+      return false;
+    std::memcpy(&header, file.data(), sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+        file.size() != sizeof(Header) + header.ticks || header.tickRate <= 0)
+      return false;
+    level = header.level;
+    tickRate = header.tickRate;
+    options.asteroidField = header.asteroidField;
+    options.dormantAsteroids = header.dormantAsteroids;
+    options.maxAsteroids = header.maxAsteroids;
+    options.gridSize = header.gridSize;
+    options.seed = header.seed;
+    const uint8_t *stored = file.data() + sizeof(Header);
+    ticks.assign(stored, stored + header.ticks);
+    return true;
+  }
+
+private:
+  static constexpr char Magic[8] = {'A', 'T', 'S', 'R', 'E', 'C', 'D', '4'};
+
+  struct Header {
+    char magic[8];
+    int32_t level;
+    float tickRate;
+    uint32_t asteroidField;
+    int32_t dormantAsteroids;
+    int32_t maxAsteroids;
+    int32_t gridSize;
+    uint64_t seed;
+    uint64_t ticks;
+  };
+
+  std::vector<uint8_t> ticks; // bit per key, see add
+};
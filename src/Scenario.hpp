@@ -0,0 +1,144 @@
+#pragma once
+#include "Background.hpp"
+#include "FrameTimes.hpp"
+#include "World.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+// One point of a scalability sweep: a headless level ticked for a fixed
+// number of ticks, whatever happens to the player, with the knobs below.
+struct Scenario {
+  int level = 0;
+  uint64_t ticks = 600;
+  float tickRate = 60.0f;
+  WorldOptions world;
+  unsigned threads = 0; // 0 = one per core
+  float starDensity = STAR_DENSITY;
+  int tileSize = 1024;
+
+  // Sets the knob called `name` (asteroids, grid-size, dormant, threads,
+  // star-density, tile-size), returns false for an unknown name or a value
+  // the knob cannot take.
+  bool set(std::string_view name, double value) {
+    if (name == "asteroids")
+      world.maxAsteroids = static_cast<int>(value);
+    else if (name == "grid-size" && value >= minGridSize())
+      world.gridSize = static_cast<int>(value);
+    else if (name == "dormant")
+      world.dormantAsteroids = static_cast<int>(value);
+    else if (name == "threads")
+      threads = static_cast<unsigned>(value);
+    else if (name == "star-density")
+      starDensity = static_cast<float>(value);
+    else if (name == "tile-size" &&
+             Background::isValidTileSize(static_cast<int>(value)))
+      tileSize = static_cast<int>(value);
+    else
+      return false;
+    return true;
+  }
+};
+
+// Milliseconds per tick (a headless frame), per World::tick and per
+// collision check, and per background tile painted.
+struct ScenarioResult {
+  size_t asteroids = 0; // most in play at once
+  double frame = 0, frameP99 = 0;
+  double tick = 0, collisions = 0;
+  double tile = 0;
+};
+
+inline ScenarioResult runScenario(const Scenario &scenario) {
+  using Clock = std::chrono::steady_clock;
+  using Ms = std::chrono::duration<double, std::milli>;
+  ThreadPool::setGlobalSize(scenario.threads);
+  bool profiling = Profiler::isEnabled();
+  Profiler::setEnabled(true);
+  int64_t since = Profiler::now();
+
+  ScenarioResult result;
+  {
+    World world(scenario.level, scenario.world);
+    inputs input;
+    FrameTimes frames;
+    const float dt = 1.0f / scenario.tickRate;
+    for (uint64_t i = 0; i < scenario.ticks; ++i) {
+      auto start = Clock::now();
+      world.tick(dt, input);
+      frames.add(Ms(Clock::now() - start).count());
+    }
+    result.asteroids = world.asteroids->getPoolStats().highWater;
+    result.frame = frames.mean();
+    result.frameP99 = frames.percentile(0.99);
+  }
+
+  // Means per scope rather than totals, the profiler rings may have wrapped.
+  auto meanOf = [since](const char *name) {
+    double total = 0;
+    size_t count = 0;
+    Profiler::forEachEvent(since, [&](uint32_t, const Profiler::Event &e) {
+      if (std::strcmp(e.name, name) == 0) {
+        total += e.duration;
+        ++count;
+      }
+    });
+    return count ? total / count / 1e6 : 0.0;
+  };
+  result.tick = meanOf("World tick");
+  result.collisions = meanOf("Check collisions");
+  Profiler::setEnabled(profiling);
+
+  Background sky(scenario.starDensity, scenario.world.seed, scenario.tileSize,
+                 1);
+  std::vector<uint8_t> grey;
+  const int tiles = 3;
+  auto start = Clock::now();
+  for (int i = 0; i < tiles; ++i)
+    sky.paintTile({i, 0}, grey);
+  result.tile = Ms(Clock::now() - start).count() / tiles;
+  return result;
+}
+
+// Runs `base` with the knob `name` going from `from` to `to`, multiplied by
+// `factor` each step, printing every point and writing them as CSV rows to
+// `csv` if it is not empty. Without a name `base` runs once.
+inline bool runSweep(Scenario base, std::string_view name, double from,
+                     double to, double factor, const std::string &csv) {
+  if (name.empty())
+    from = to = factor = 2;
+  else if (factor <= 1 || from <= 0)
+    return false;
+  // Every point is checked before the first one runs.
+  for (double value = from; value <= to * 1.000001; value *= factor)
+    if (!name.empty() && !base.set(name, value))
+      return false;
+  std::ofstream file;
+  if (!csv.empty()) {
+    file.open(csv, std::ios::trunc);
+    file << "asteroids,grid_size,dormant,threads,star_density,tile_size,"
+            "in_play,frame_ms,frame_p99_ms,tick_ms,collision_ms,tile_ms\n";
+  }
+  for (double value = from; value <= to * 1.000001; value *= factor) {
+    Scenario scenario = base;
+    if (!name.empty())
+      scenario.set(name, value);
+    auto result = runScenario(scenario);
+    auto row = fmt::format(
+        "{},{},{},{},{:g},{},{},{:.4f},{:.4f},{:.4f},{:.4f},{:.3f}",
+        scenario.world.maxAsteroids, scenario.world.gridSize,
+        scenario.world.dormantAsteroids, ThreadPool::global().size(),
+        scenario.starDensity, scenario.tileSize,
+        result.asteroids, result.frame, result.frameP99, result.tick,
+        result.collisions, result.tile);
+    if (name.empty())
+      fmt::println("{}", row);
+    else
+      fmt::println("{}={:g}: {}", name, value, row);
+    if (file.is_open())
+      file << row << '\n';
+  }
+  return !file.is_open() || static_cast<bool>(file);
+}
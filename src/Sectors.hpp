@@ -0,0 +1,137 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Asteroids that drifted out of the simulated area around the player. They
+// are not ticked: each keeps flying in a straight line, its position worked
+// out from where and when it was parked. They sit in square sectors so the
+// ones coming back into range are found without looking at the rest, and are
+// moved between sectors only once every RebinInterval seconds.
+class Sectors {
+public:
+  struct Dormant {
+    sf::Vector2f pos, vel; // when parked
+    double since;
+    sf::Vector2f at(double now) const {
+      return pos + vel * static_cast<float>(now - since);
+    }
+  };
+
+  // At most `capacity` asteroids are kept, the sectors farthest from the
+  // player are dropped on the next rebin when there are more.
+  Sectors(float sectorSize, size_t capacity)
+      : sectorSize(sectorSize), capacity(capacity) {}
+
+  size_t size() const { return count; }
+
+  void park(sf::Vector2f pos, sf::Vector2f vel, double now) {
+    if (!capacity)
+      return;
+    sectors[keyOf(pos)].push_back({pos, vel, now});
+    ++count;
+    maxSpeed = std::max(maxSpeed, std::hypot(vel.x, vel.y));
+  }
+
+  // Offers take(pos, vel) every asteroid now within `radius` of `center`,
+  // sector by sector; those it takes (returns true for) stop being dormant.
+  template <typename F>
+  void wake(sf::Vector2f center, float radius, double now, F &&take) {
+    if (!count)
+      return;
+    // Asteroids may have left their sector since the last rebin.
+    float reach = radius + maxSpeed * static_cast<float>(now - rebinned);
+    int32_t x0 = cellOf(center.x - reach), x1 = cellOf(center.x + reach);
+    int32_t y0 = cellOf(center.y - reach), y1 = cellOf(center.y + reach);
+    float radius2 = radius * radius;
+    for (int32_t y = y0; y <= y1; ++y)
+      for (int32_t x = x0; x <= x1; ++x) {
+        auto it = sectors.find(key(x, y));
+        if (it == sectors.end())
+          continue;
+        auto &members = it->second;
+        for (size_t i = 0; i < members.size();) {
+          sf::Vector2f pos = members[i].at(now), d = pos - center;
+          if (d.x * d.x + d.y * d.y >= radius2 || !take(pos, members[i].vel)) {
+            ++i;
+            continue;
+          }
+          members[i] = members.back();
+          members.pop_back();
+          --count;
+        }
+      }
+  }
+
+  // Moves asteroids into the sector they drifted to and enforces capacity,
+  // once every RebinInterval seconds.
+  void maintain(sf::Vector2f center, double now) {
+    if (now - rebinned < RebinInterval)
+      return;
+    rebinned = now;
+    maxSpeed = 0;
+    moved.clear();
+    for (auto it = sectors.begin(); it != sectors.end();) {
+      auto &members = it->second;
+      for (size_t i = 0; i < members.size();) {
+        maxSpeed = std::max(maxSpeed,
+                            std::hypot(members[i].vel.x, members[i].vel.y));
+        if (keyOf(members[i].at(now)) == it->first) {
+          ++i;
+          continue;
+        }
+        moved.push_back(members[i]);
+        members[i] = members.back();
+        members.pop_back();
+      }
+      it = members.empty() ? sectors.erase(it) : std::next(it);
+    }
+    for (auto &asteroid : moved)
+      sectors[keyOf(asteroid.at(now))].push_back(asteroid);
+
+    while (count > capacity) {
+      auto farthest = sectors.begin();
+      float farthest2 = -1;
+      for (auto it = sectors.begin(); it != sectors.end(); ++it) {
+        sf::Vector2f d = centerOf(it->first) - center;
+        if (d.x * d.x + d.y * d.y > farthest2) {
+          farthest2 = d.x * d.x + d.y * d.y;
+          farthest = it;
+        }
+      }
+      count -= farthest->second.size();
+      sectors.erase(farthest);
+    }
+  }
+
+private:
+  static constexpr double RebinInterval = 0.5; // seconds
+
+  static uint64_t key(int32_t x, int32_t y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+           static_cast<uint32_t>(y);
+  }
+  int32_t cellOf(float v) const {
+    return static_cast<int32_t>(std::floor(v / sectorSize));
+  }
+  uint64_t keyOf(sf::Vector2f pos) const {
+    return key(cellOf(pos.x), cellOf(pos.y));
+  }
+  sf::Vector2f centerOf(uint64_t k) const {
+    auto x = static_cast<int32_t>(static_cast<uint32_t>(k >> 32));
+    auto y = static_cast<int32_t>(static_cast<uint32_t>(k));
+    return {(x + 0.5f) * sectorSize, (y + 0.5f) * sectorSize};
+  }
+
+  float sectorSize;
+  size_t capacity;
+  size_t count = 0;
+  float maxSpeed = 0; // of any dormant asteroid
+  double rebinned = 0;
+  std::map<uint64_t, std::vector<Dormant>> sectors; // ordered, so replays match
+  std::vector<Dormant> moved;                       // rebin scratch
+};
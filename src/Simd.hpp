@@ -0,0 +1,34 @@
+#pragma once
+
+// x86 SIMD paths are compiled with per-function target attributes and picked
+// at runtime, so the default build flags keep working on any x86-64 CPU.
+#if defined(__x86_64__) || defined(__i386__)
+#define AMONG_THE_STARS_X86 1
+#include <immintrin.h>
+#define AMONG_THE_STARS_AVX2 __attribute__((target("avx2")))
+#define AMONG_THE_STARS_SSE2 __attribute__((target("sse2")))
+#else
+#define AMONG_THE_STARS_X86 0
+#endif
+
+namespace simd {
+
+inline bool hasAvx2() {
+#if AMONG_THE_STARS_X86
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+#else
+  return false;
+#endif
+}
+
+inline bool hasSse2() {
+#if AMONG_THE_STARS_X86
+  static const bool sse2 = __builtin_cpu_supports("sse2");
+  return sse2;
+#else
+  return false;
+#endif
+}
+
+} // namespace simd
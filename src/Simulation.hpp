@@ -0,0 +1,140 @@
+#pragma once
+#include "Recording.hpp"
+#include "World.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+// Ticks a World on its own thread at a fixed rate, so how the level plays out
+// does not depend on the frame rate. After each tick the World is copied into
+// a snapshot; the render thread reads the last two and draws in between.
+//
+// Only the simulation thread touches the World while it runs. Work that must
+// not overlap a tick, like growing the texture atlas ticks read from, goes
+// through betweenTicks.
+class Simulation {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  Simulation(World &world, float tickRate)
+      : world(world), dt(1.0f / tickRate),
+        step(std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<float>(dt))) {
+    world.snapshot(current);
+    previous = current;
+    publishedAt = Clock::now();
+  }
+
+  ~Simulation() { stop(); }
+
+  Simulation(const Simulation &) = delete;
+  Simulation &operator=(const Simulation &) = delete;
+
+  void start() {
+    running = true;
+    thread = std::thread([this] { run(); });
+  }
+
+  // Returns once the thread is done with the current tick.
+  void stop() {
+    running = false;
+    if (thread.joinable())
+      thread.join();
+  }
+
+  // Read at the start of every tick.
+  void setInput(const inputs &input) {
+    std::lock_guard lock(mutex);
+    this->input = input;
+  }
+
+  // Copies the last two snapshots and returns how far the present is past
+  // `previous`, in ticks: 0 shows previous, 1 current.
+  float read(WorldSnapshot &previous, WorldSnapshot &current) {
+    std::lock_guard lock(mutex);
+    previous = this->previous;
+    current = this->current;
+    std::chrono::duration<float> since = Clock::now() - publishedAt;
+    return std::clamp(since.count() / dt, 0.0f, 1.0f);
+  }
+
+  // Runs f() on the calling thread unless a tick is in progress, in which
+  // case it returns false right away rather than waiting for the tick.
+  template <typename F> bool betweenTicks(F &&f) {
+    std::unique_lock lock(tickMutex, std::try_to_lock);
+    if (!lock)
+      return false;
+    f();
+    return true;
+  }
+
+  // True once the thread stopped ticking, because the level ended, the
+  // replay ran out or stop was called.
+  bool isOver() const { return over; }
+
+  // Ticks take their input from `replay` instead of setInput and stop when it
+  // runs out. Set before start; `replay` must outlive the simulation.
+  void setReplay(const Recording *replay) { this->replay = replay; }
+  // The input of every tick is appended to `record`. Set before start, read
+  // after stop.
+  void setRecording(Recording *record) { this->record = record; }
+  float getDt() const { return dt; }
+
+private:
+  void run() {
+    auto next = Clock::now();
+    for (size_t tick = 0; running && !world.isOver(); ++tick) {
+      inputs tickInput;
+      if (replay) {
+        if (tick >= replay->size())
+          break;
+        tickInput = replay->at(tick);
+      } else {
+        std::lock_guard lock(mutex);
+        tickInput = input;
+      }
+      if (record)
+        record->add(tickInput);
+      {
+        std::lock_guard ticking(tickMutex);
+        world.tick(dt, tickInput);
+        world.snapshot(back);
+      }
+      {
+        std::lock_guard lock(mutex);
+        std::swap(previous, current);
+        std::swap(current, back);
+        publishedAt = Clock::now();
+      }
+
+      // Ticks that fell behind run back to back, but after a long stall
+      // (a debugger, a dragged window) the backlog is dropped.
+      next += step;
+      auto now = Clock::now();
+      if (now - next > MaxLag)
+        next = now;
+      std::this_thread::sleep_until(next);
+    }
+    over = true;
+  }
+
+  static constexpr std::chrono::milliseconds MaxLag{250};
+
+  World &world;
+  const float dt;
+  const Clock::duration step;
+  std::thread thread;
+  std::atomic<bool> running = false;
+  std::atomic<bool> over = false;
+  const Recording *replay = nullptr;
+  Recording *record = nullptr;
+
+  std::mutex tickMutex; // held for every tick, see betweenTicks
+  std::mutex mutex;     // guards everything below but `back`
+  inputs input;
+  WorldSnapshot previous, current;
+  Clock::time_point publishedAt;
+  WorldSnapshot back; // filled by the simulation thread outside the lock
+};
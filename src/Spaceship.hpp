@@ -0,0 +1,52 @@
+#pragma once
+#include "Player.hpp"
+#include "Random.hpp"
+#include "fmt/base.h"
+
+class Spaceship : public Tickable, public Movable, public GameObject {
+public:
+  static constexpr CollisionLayer Layer = CollisionLayer::Spaceship;
+
+  Spaceship(float minDistanceFromPlayer, Random random = Random())
+      : GameObject("./assets/spaceship_scaled.png", {0, 0},
+                   CollisionLayer::Spaceship) {
+    auto randomOffset = [&random](float min, float max) {
+      return random.uniform(min, max);
+    };
+
+    while (true) {
+      sf::Vector2f pos{randomOffset(-2048.0f, 2048.0f),
+                       randomOffset(-2048.0f, 2048.0f)};
+
+      // Ensure the spaceship is sufficiently far from the origin (player's
+      // initial position)
+      if (VecLength(pos) >= minDistanceFromPlayer) {
+        setPosition(pos);
+        setPos(pos.x, pos.y);
+        break;
+      }
+    }
+
+    setDefaultRect({0, 0, static_cast<int>(textureSize.x),
+                    static_cast<int>(textureSize.y)});
+  }
+  virtual void tick(float dt) override {
+    if (!PlayerRef)
+      return;
+    if (!intersects(*PlayerRef)) {
+      PlayerRef->zeroPlayerTimer();
+    } else {
+      PlayerRef->updateTimer(dt);
+      PlayerRef->addResources(2.0f * dt, 10 * dt);
+    }
+  }
+  void onColision(Player &player, float dt) {
+    if (intersects(player)) {
+      fmt::println("Player Found Ship!");
+      PlayerRef = &player;
+    }
+  }
+
+private:
+  Player *PlayerRef = nullptr;
+};
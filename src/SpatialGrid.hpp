@@ -0,0 +1,236 @@
+#pragma once
+#include "GameObject.hpp"
+#include "Overlap.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Uniform grid over world space that is kept between frames. Cells live in an
+// open-addressing hash table and keep their member storage when they empty
+// out, so a steady-state update does not allocate. Objects are only moved
+// between cells when they actually cross a cell border.
+//
+// An object can be registered in one grid at a time.
+class SpatialGrid {
+public:
+  explicit SpatialGrid(int cellSize = 200) : cellSize(cellSize) {
+    table.resize(64, 0);
+  }
+
+  // Brings the grid in line with `objects`: new objects are inserted, objects
+  // that crossed into another cell are relocated and objects missing from
+  // `objects` (despawned) are dropped. The bounds of every object are
+  // recomputed once here, see bounds().
+  void update(const std::vector<std::shared_ptr<GameObject>> &objects) {
+    ++stamp;
+    for (auto &obj : objects) {
+      obj->updateBounds();
+      sf::Vector2i cell = cellOf(obj->getSprite().getPosition());
+      uint32_t handle = obj->gridHandle;
+      if (handle < entries.size() && entries[handle].obj == obj) {
+        entries[handle].stamp = stamp;
+        if (entries[handle].cell != cell) {
+          unlink(handle);
+          link(handle, cell);
+        }
+        continue;
+      }
+      handle = static_cast<uint32_t>(entries.size());
+      entries.push_back({obj, cell, 0, 0, stamp, obj->getLayer()});
+      obj->gridHandle = handle;
+      link(handle, cell);
+    }
+
+    for (uint32_t i = 0; i < entries.size();) {
+      if (entries[i].stamp == stamp)
+        ++i;
+      else
+        remove(i);
+    }
+
+    // Bounds are packed cell after cell, in member order, so every cell is a
+    // contiguous run for forEachOverlap.
+    packed.resize(entries.size());
+    packedHandles.resize(entries.size());
+    uint32_t next = 0;
+    for (auto &cell : cells) {
+      cell.first = next;
+      for (auto member : cell.members) {
+        packed.set(next, entries[member].obj->getBounds());
+        packedHandles[next++] = member;
+      }
+    }
+  }
+
+  // Calls f(a, b) with the handles of every pair of objects whose bounds
+  // overlap (see overlaps()) and that share a cell or sit in neighbouring
+  // cells, exactly once per pair. Each cell is paired with itself and with
+  // four of its eight neighbours, the other four pair with it from their
+  // side. Each object is tested against a whole neighbouring cell at once.
+  template <typename F> void forEachOverlap(F &&f) {
+    static const sf::Vector2i forward[] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+    auto run = [this, &f](uint32_t one, uint32_t begin, uint32_t end) {
+      overlapBits.resize((end - begin + 63) / 64);
+      packed.overlapMask(one, begin, end, overlapBits.data());
+      for (size_t w = 0; w < overlapBits.size(); ++w)
+        for (uint64_t bits = overlapBits[w]; bits; bits &= bits - 1)
+          f(packedHandles[one],
+            packedHandles[begin + w * 64 + std::countr_zero(bits)]);
+    };
+    for (auto &cell : cells) {
+      uint32_t first = cell.first;
+      uint32_t last = first + static_cast<uint32_t>(cell.members.size());
+      for (uint32_t i = first; i + 1 < last; ++i)
+        run(i, i + 1, last);
+
+      if (first == last)
+        continue;
+      for (auto offset : forward) {
+        uint32_t neighbor = find(cell.pos + offset);
+        if (neighbor == npos || cells[neighbor].members.empty())
+          continue;
+        auto &other = cells[neighbor];
+        for (uint32_t i = first; i < last; ++i)
+          run(i, other.first,
+              other.first + static_cast<uint32_t>(other.members.size()));
+      }
+    }
+  }
+
+  // Handles are dense, in [0, size()), and stay valid until the next update.
+  const std::shared_ptr<GameObject> &object(uint32_t handle) const {
+    return entries[handle].obj;
+  }
+  CollisionLayer layer(uint32_t handle) const { return entries[handle].layer; }
+  size_t size() const { return entries.size(); }
+  int getCellSize() const { return cellSize; }
+
+private:
+  struct Entry {
+    std::shared_ptr<GameObject> obj;
+    sf::Vector2i cell;
+    uint32_t cellIndex;
+    uint32_t slot; // position inside cells[cellIndex].members
+    uint32_t stamp;
+    CollisionLayer layer; // copied so pair filtering stays in the grid
+  };
+
+  struct Cell {
+    sf::Vector2i pos;
+    std::vector<uint32_t> members;
+    uint32_t first = 0; // of its run in `packed`
+  };
+
+  static constexpr uint32_t npos = ~0u;
+
+  sf::Vector2i cellOf(const sf::Vector2f &pos) const {
+    return {static_cast<int>(std::floor(pos.x / cellSize)),
+            static_cast<int>(std::floor(pos.y / cellSize))};
+  }
+
+  static uint64_t hash(sf::Vector2i pos) {
+    uint64_t key = (static_cast<uint64_t>(static_cast<uint32_t>(pos.x)) << 32) |
+                   static_cast<uint32_t>(pos.y);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+  }
+
+  uint32_t find(sf::Vector2i pos) const {
+    size_t mask = table.size() - 1;
+    for (size_t i = hash(pos) & mask; table[i]; i = (i + 1) & mask)
+      if (cells[table[i] - 1].pos == pos)
+        return table[i] - 1;
+    return npos;
+  }
+
+  uint32_t findOrCreate(sf::Vector2i pos) {
+    size_t mask = table.size() - 1;
+    size_t i = hash(pos) & mask;
+    for (; table[i]; i = (i + 1) & mask)
+      if (cells[table[i] - 1].pos == pos)
+        return table[i] - 1;
+
+    // Keep the load factor under one half.
+    if ((cells.size() + 1) * 2 > table.size()) {
+      rehash();
+      return findOrCreate(pos);
+    }
+    cells.push_back({pos, {}});
+    table[i] = static_cast<uint32_t>(cells.size());
+    return static_cast<uint32_t>(cells.size() - 1);
+  }
+
+  // Drops cells that emptied out (the player left them behind) and grows the
+  // table if the live cells alone would still fill it.
+  void rehash() {
+    size_t live = 0;
+    for (size_t i = 0; i < cells.size(); ++i) {
+      if (cells[i].members.empty())
+        continue;
+      if (i != live) {
+        cells[live] = std::move(cells[i]);
+        for (auto member : cells[live].members)
+          entries[member].cellIndex = static_cast<uint32_t>(live);
+      }
+      ++live;
+    }
+    cells.resize(live);
+
+    size_t capacity = 64;
+    while (capacity < (live + 1) * 4)
+      capacity *= 2;
+    table.assign(capacity, 0);
+    size_t mask = capacity - 1;
+    for (size_t c = 0; c < cells.size(); ++c) {
+      size_t i = hash(cells[c].pos) & mask;
+      while (table[i])
+        i = (i + 1) & mask;
+      table[i] = static_cast<uint32_t>(c + 1);
+    }
+  }
+
+  void link(uint32_t handle, sf::Vector2i pos) {
+    uint32_t cellIndex = findOrCreate(pos);
+    auto &members = cells[cellIndex].members;
+    auto &entry = entries[handle];
+    entry.cell = pos;
+    entry.cellIndex = cellIndex;
+    entry.slot = static_cast<uint32_t>(members.size());
+    members.push_back(handle);
+  }
+
+  void unlink(uint32_t handle) {
+    auto &entry = entries[handle];
+    auto &members = cells[entry.cellIndex].members;
+    uint32_t last = members.back();
+    members[entry.slot] = last;
+    entries[last].slot = entry.slot;
+    members.pop_back();
+  }
+
+  void remove(uint32_t handle) {
+    unlink(handle);
+    uint32_t last = static_cast<uint32_t>(entries.size() - 1);
+    if (handle != last) {
+      entries[handle] = std::move(entries[last]);
+      auto &moved = entries[handle];
+      moved.obj->gridHandle = handle;
+      cells[moved.cellIndex].members[moved.slot] = handle;
+    }
+    entries.pop_back();
+  }
+
+  int cellSize;
+  uint32_t stamp = 0;
+  std::vector<Entry> entries;
+  PackedBounds packed;                 // as of the last update, by cell
+  std::vector<uint32_t> packedHandles; // handle of each packed object
+  std::vector<uint64_t> overlapBits;   // forEachOverlap scratch
+  std::vector<Cell> cells;
+  std::vector<uint32_t> table; // cell index + 1, 0 marks an empty slot
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <cstdlib>
+#include <vector>
+
+// Collects sprites as textured triangles and draws everything sharing a
+// texture with a single draw call. Batches are drawn in the order their
+// texture was first added since the last flush, so a sprite only keeps its
+// place relative to sprites of the same texture. Whatever has to be on top
+// of a batch is drawn after a flush.
+class SpriteBatch {
+public:
+  // Adds a quad with the sprite's transform, texture rect and color.
+  void add(const sf::Sprite &sprite) {
+    const sf::Texture *texture = sprite.getTexture();
+    if (!texture)
+      return;
+    auto rect = sprite.getTextureRect();
+    const sf::Transform &transform = sprite.getTransform();
+    sf::Color color = sprite.getColor();
+    float w = static_cast<float>(std::abs(rect.width));
+    float h = static_cast<float>(std::abs(rect.height));
+    float left = static_cast<float>(rect.left);
+    float right = left + rect.width;
+    float top = static_cast<float>(rect.top);
+    float bottom = top + rect.height;
+
+    sf::Vertex corners[4] = {
+        {transform.transformPoint(0, 0), color, {left, top}},
+        {transform.transformPoint(w, 0), color, {right, top}},
+        {transform.transformPoint(w, h), color, {right, bottom}},
+        {transform.transformPoint(0, h), color, {left, bottom}},
+    };
+    auto &vertices = batchFor(texture).vertices;
+    for (int corner : {0, 1, 2, 0, 2, 3})
+      vertices.append(corners[corner]);
+  }
+
+  // Draws and empties every batch. The vertex storage is kept.
+  void flush(sf::RenderTarget &target) {
+    for (size_t index : pending) {
+      auto &batch = batches[index];
+      target.draw(batch.vertices, sf::RenderStates(batch.texture));
+      batch.vertices.clear();
+    }
+    pending.clear();
+  }
+
+private:
+  struct Batch {
+    const sf::Texture *texture;
+    sf::VertexArray vertices{sf::Triangles};
+  };
+
+  // A handful of textures per frame, a linear search beats hashing.
+  Batch &batchFor(const sf::Texture *texture) {
+    size_t index = 0;
+    while (index < batches.size() && batches[index].texture != texture)
+      ++index;
+    if (index == batches.size())
+      batches.push_back({texture});
+    if (batches[index].vertices.getVertexCount() == 0)
+      pending.push_back(index);
+    return batches[index];
+  }
+
+  std::vector<Batch> batches;
+  std::vector<size_t> pending; // batches holding quads, in draw order
+};
@@ -0,0 +1,263 @@
+#pragma once
+#include "Profiler.hpp"
+#include "ThreadPool.hpp"
+#include "Utils.hpp"
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Image.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Index of an image packed into one of TextureProvider's atlas pages.
+using TextureHandle = uint32_t;
+
+// Loads every image into a shared atlas: square pages the images are packed
+// into shelf by shelf, each one with a border repeating its edge pixels so
+// smooth sampling does not bleed in the neighbours. Paths are resolved to a
+// handle once, after that a lookup is an array access and all sprites on a
+// page can be drawn with a single texture bind.
+//
+// Images can be prefetched: they are decoded on the thread pool and packed
+// and uploaded on the main thread by pump, a few per frame, or by the load
+// that needs them. Everything but the decoding must happen on the main
+// thread, except lookups by handle (getTexture, getRect, getSize), which
+// other threads may do while nothing is being packed.
+class TextureProvider {
+public:
+  using Ready = std::function<void(TextureHandle)>;
+
+  // Handle of the image at `path`, packing it on first use. An image still
+  // being prefetched is waited for rather than decoded a second time.
+  static TextureHandle load(const std::filesystem::path &path) {
+    auto pathstring = path.string();
+    auto found = handles.find(pathstring);
+    if (found != handles.end())
+      return found->second;
+    for (auto it = pending.begin(); it != pending.end(); ++it)
+      if (it->path == pathstring) {
+        Pending request = std::move(*it);
+        pending.erase(it);
+        return finish(request);
+      }
+    TextureHandle handle = pack(decode(path));
+    handles.emplace(std::move(pathstring), handle);
+    return handle;
+  }
+
+  // Starts decoding the image at `path` on a worker thread. `ready` is
+  // called from pump (or load) once it is packed, right away if it already
+  // is.
+  static void prefetch(const std::filesystem::path &path, Ready ready = {}) {
+    auto pathstring = path.string();
+    auto found = handles.find(pathstring);
+    if (found != handles.end()) {
+      if (ready)
+        ready(found->second);
+      return;
+    }
+    for (auto &request : pending)
+      if (request.path == pathstring) {
+        if (ready)
+          request.ready.push_back(std::move(ready));
+        return;
+      }
+    Pending request{pathstring, ThreadPool::global().submit(decode, path)};
+    if (ready)
+      request.ready.push_back(std::move(ready));
+    pending.push_back(std::move(request));
+  }
+
+  // Packs and uploads decoded prefetches until `budget` is used up, at least
+  // one if any is ready. Returns how many are still outstanding. Packing
+  // may move the atlas, so nothing may look handles up meanwhile, see
+  // Simulation::betweenTicks.
+  static size_t pump(std::chrono::microseconds budget) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < pending.size();) {
+      if (pending[i].image.wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+        ++i;
+        continue;
+      }
+      Pending request = std::move(pending[i]);
+      pending.erase(pending.begin() + i);
+      finish(request);
+      if (std::chrono::steady_clock::now() - start >= budget)
+        break;
+    }
+    return pending.size();
+  }
+
+  // Page holding the image, draw it with getRect as the texture rect.
+  static const sf::Texture &getTexture(TextureHandle handle) {
+    return pages[regions[handle].page]->texture;
+  }
+  static sf::IntRect getRect(TextureHandle handle) {
+    return regions[handle].rect;
+  }
+  // Size of the image, valid in headless mode as well, where nothing is
+  // uploaded.
+  static sf::Vector2u getSize(TextureHandle handle) {
+    auto &rect = regions[handle].rect;
+    return {static_cast<unsigned>(rect.width),
+            static_cast<unsigned>(rect.height)};
+  }
+
+  static const sf::Texture &getTexture(std::filesystem::path path) {
+    return getTexture(load(path));
+  }
+
+  // Reads the default font file on a worker thread, getDefaultFont then
+  // only has to hand the bytes to FreeType.
+  static void prefetchDefaultFont() {
+    if (defaultFont || fontFile.valid())
+      return;
+    fontFile = ThreadPool::global().submit([] {
+      PROFILE_SCOPE("Read font");
+      std::ifstream file(defaultFontPath(), std::ios::binary);
+      return std::vector<char>(std::istreambuf_iterator<char>(file), {});
+    });
+  }
+
+  static std::shared_ptr<sf::Font> getDefaultFont() {
+    std::cout << "Looking for default font" << std::endl;
+    if (defaultFont)
+      return defaultFont;
+    PROFILE_SCOPE("Load font");
+    defaultFont = std::make_shared<sf::Font>();
+    if (fontFile.valid()) {
+      // sf::Font reads from this buffer for as long as it lives.
+      fontBytes = fontFile.get();
+      defaultFont->loadFromMemory(fontBytes.data(), fontBytes.size());
+    } else {
+      defaultFont->loadFromFile(defaultFontPath());
+    }
+    std::cout << "default Font loaded" << std::endl;
+    return getDefaultFont();
+  }
+
+private:
+  static const unsigned PageSize = 2048;
+  static const unsigned Padding = 2;
+
+  struct Region {
+    uint32_t page;
+    sf::IntRect rect;
+  };
+
+  struct Page {
+    sf::Texture texture;
+    unsigned size;
+    unsigned shelfX = 0, shelfY = 0, shelfHeight = 0;
+  };
+
+  struct Pending {
+    std::string path;
+    std::future<sf::Image> image;
+    std::vector<Ready> ready;
+  };
+
+  static std::string defaultFontPath() {
+    return std::filesystem::absolute("./fonts/Audiowide-Regular.ttf").string();
+  }
+
+  // Only touches its own sf::Image, safe to run on any thread.
+  static sf::Image decode(const std::filesystem::path &path) {
+    PROFILE_SCOPE("Decode texture");
+    auto pathString = std::filesystem::absolute(path).string(); 
+    sf::Image image;
+    image.loadFromFile(pathString.c_str());
+    return image;
+  }
+
+  static TextureHandle finish(Pending &request) {
+    TextureHandle handle = pack(request.image.get());
+    handles.emplace(request.path, handle);
+    for (auto &ready : request.ready)
+      ready(handle);
+    return handle;
+  }
+
+  static TextureHandle pack(const sf::Image &image) {
+    PROFILE_SCOPE("Pack texture");
+    auto size = image.getSize();
+    unsigned width = size.x + 2 * Padding, height = size.y + 2 * Padding;
+
+    sf::Vector2u corner;
+    uint32_t page = place(width, height, corner);
+    // No GL context to upload into when headless, the size is all we need.
+    if (!HEADLESS && size.x && size.y)
+      pages[page]->texture.update(padded(image), corner.x, corner.y);
+    regions.push_back({page, {static_cast<int>(corner.x + Padding),
+                              static_cast<int>(corner.y + Padding),
+                              static_cast<int>(size.x),
+                              static_cast<int>(size.y)}});
+    return static_cast<TextureHandle>(regions.size() - 1);
+  }
+
+  // Finds room for a width x height block, on the last shelf of the last
+  // page, on a new shelf below it or on a new page.
+  static uint32_t place(unsigned width, unsigned height,
+                        sf::Vector2u &corner) {
+    if (!pages.empty()) {
+      Page &page = *pages.back();
+      if (page.shelfX + width > page.size) {
+        page.shelfY += page.shelfHeight;
+        page.shelfX = page.shelfHeight = 0;
+      }
+      if (page.shelfX + width <= page.size &&
+          page.shelfY + height <= page.size) {
+        corner = {page.shelfX, page.shelfY};
+        page.shelfX += width;
+        page.shelfHeight = std::max(page.shelfHeight, height);
+        return static_cast<uint32_t>(pages.size() - 1);
+      }
+    }
+    // Images bigger than a page get a page of their own.
+    auto page = std::make_unique<Page>();
+    page->size = std::max({PageSize, width, height});
+    if (!HEADLESS) {
+      page->texture.create(page->size, page->size);
+      page->texture.setSmooth(true);
+    }
+    page->shelfX = width;
+    page->shelfHeight = height;
+    corner = {0, 0};
+    pages.push_back(std::move(page));
+    return static_cast<uint32_t>(pages.size() - 1);
+  }
+
+  // The image with its edge pixels repeated Padding times around it.
+  static sf::Image padded(const sf::Image &image) {
+    auto size = image.getSize();
+    sf::Image result;
+    result.create(size.x + 2 * Padding, size.y + 2 * Padding);
+    for (unsigned y = 0; y < result.getSize().y; ++y)
+      for (unsigned x = 0; x < result.getSize().x; ++x) {
+        unsigned sx = std::clamp<int>(x - Padding, 0, size.x - 1);
+        unsigned sy = std::clamp<int>(y - Padding, 0, size.y - 1);
+        result.setPixel(x, y, image.getPixel(sx, sy));
+      }
+    return result;
+  }
+
+  inline static std::vector<std::unique_ptr<Page>> pages = {};
+  inline static std::vector<Region> regions = {};
+  inline static std::unordered_map<std::string, TextureHandle> handles = {};
+  inline static std::vector<Pending> pending = {};
+  inline static std::shared_ptr<sf::Font> defaultFont = nullptr;
+  inline static std::future<std::vector<char>> fontFile = {};
+  inline static std::vector<char> fontBytes = {};
+};
@@ -0,0 +1,201 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work-stealing pool. Every worker has its own deque of tasks, it runs the
+// newest one first and when it runs dry steals the oldest task of another
+// worker. submit queues a single task, parallelFor splits an index range into
+// chunks claimed by the caller and by helper tasks. Any thread may call in,
+// several at once, and tasks may call back into the pool.
+class ThreadPool {
+public:
+  explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency()) {
+    threads = std::max(1u, threads);
+    queues = std::vector<Queue>(threads - 1);
+    for (unsigned i = 1; i < threads; ++i)
+      workers.emplace_back([this, i] { workerLoop(i - 1); });
+  }
+
+  // Runs the tasks still queued before returning.
+  ~ThreadPool() {
+    {
+      std::lock_guard lock(sleepMutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+      worker.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Threads taking part in a parallelFor, the caller included.
+  unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+  // Runs f(args...) on a worker, on the caller right away if the pool has
+  // none.
+  template <typename F, typename... Args>
+  auto submit(F &&f, Args &&...args) {
+    using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Args>...>;
+    auto task = std::make_shared<std::packaged_task<R()>>(
+        [f = std::forward<F>(f),
+         ... args = std::forward<Args>(args)]() mutable {
+          return std::invoke(f, args...);
+        });
+    auto result = task->get_future();
+    if (workers.empty())
+      (*task)();
+    else
+      push([task] { (*task)(); });
+    return result;
+  }
+
+  // Calls body(begin, end) over [0, count) in chunks of at most `grain`.
+  // Ranges no bigger than one chunk run inline on the caller.
+  void parallelFor(size_t count, size_t grain,
+                   const std::function<void(size_t, size_t)> &body) {
+    grain = std::max<size_t>(grain, 1);
+    if (workers.empty() || count <= grain) {
+      if (count)
+        body(0, count);
+      return;
+    }
+    auto job = std::make_shared<Job>();
+    job->body = &body;
+    job->count = count;
+    job->grain = grain;
+    job->chunks = (count + grain - 1) / grain;
+    size_t helpers = std::min(workers.size(), job->chunks - 1);
+    for (size_t i = 0; i < helpers; ++i)
+      push([job] { job->run(); });
+
+    job->run();
+    // Every chunk is claimed by now, only the ones still running are waited
+    // for. Helpers starting later find nothing left and never touch body.
+    for (size_t done; (done = job->finished.load()) < job->chunks;)
+      job->finished.wait(done);
+  }
+
+  static ThreadPool &global() { return *globalSlot(); }
+
+  // Replaces the global pool with one of `threads` threads (0 = one per
+  // core). Nothing may be using the pool meanwhile.
+  static void setGlobalSize(unsigned threads) {
+    if (threads == 0)
+      threads = std::thread::hardware_concurrency();
+    if (threads != global().size())
+      globalSlot() = std::make_unique<ThreadPool>(threads);
+  }
+
+private:
+  using Task = std::function<void()>;
+
+  static std::unique_ptr<ThreadPool> &globalSlot() {
+    static std::unique_ptr<ThreadPool> pool = std::make_unique<ThreadPool>();
+    return pool;
+  }
+
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  struct Job {
+    const std::function<void(size_t, size_t)> *body = nullptr;
+    size_t count = 0;
+    size_t grain = 1;
+    size_t chunks = 0;
+    std::atomic<size_t> next = 0;
+    std::atomic<size_t> finished = 0;
+
+    void run() {
+      for (size_t chunk; (chunk = next.fetch_add(1)) < chunks;) {
+        size_t begin = chunk * grain;
+        (*body)(begin, std::min(begin + grain, count));
+        if (finished.fetch_add(1) + 1 == chunks)
+          finished.notify_all();
+      }
+    }
+  };
+
+  // Workers queue onto their own deque, other threads spread their tasks
+  // round robin.
+  void push(Task task) {
+    size_t index = ownPool == this ? ownQueue
+                                   : nextQueue.fetch_add(1) % queues.size();
+    {
+      std::lock_guard lock(queues[index].mutex);
+      queues[index].tasks.push_back(std::move(task));
+    }
+    queued.fetch_add(1);
+    // Taking the lock orders this with a worker between checking `queued`
+    // and going to sleep.
+    { std::lock_guard lock(sleepMutex); }
+    wake.notify_one();
+  }
+
+  bool pop(size_t index, Task &task) {
+    {
+      auto &own = queues[index];
+      std::lock_guard lock(own.mutex);
+      if (!own.tasks.empty()) {
+        task = std::move(own.tasks.back());
+        own.tasks.pop_back();
+        queued.fetch_sub(1);
+        return true;
+      }
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+      auto &victim = queues[(index + i) % queues.size()];
+      std::lock_guard lock(victim.mutex);
+      if (!victim.tasks.empty()) {
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        queued.fetch_sub(1);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void workerLoop(size_t index) {
+    ownPool = this;
+    ownQueue = index;
+    Task task;
+    while (true) {
+      if (pop(index, task)) {
+        task();
+        task = nullptr;
+        continue;
+      }
+      std::unique_lock lock(sleepMutex);
+      wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+      if (stopping && queued.load() == 0)
+        return;
+    }
+  }
+
+  // Pool and queue of the worker running on this thread, if any.
+  inline static thread_local const ThreadPool *ownPool = nullptr;
+  inline static thread_local size_t ownQueue = 0;
+
+  std::vector<std::thread> workers;
+  std::vector<Queue> queues; // one per worker
+  std::atomic<size_t> queued = 0;
+  std::atomic<size_t> nextQueue = 0;
+  std::mutex sleepMutex;
+  std::condition_variable wake;
+  bool stopping = false;
+};
@@ -0,0 +1,101 @@
+#pragma once
+#include "MappedFile.hpp"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fmt/format.h>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+// Generated background tiles kept on disk between levels and launches. A
+// tile is stored as one byte per pixel (stars are shades of grey on opaque
+// black) after a header repeating everything it was generated from, so a
+// file left behind by another sky, tile size or generator is treated as
+// missing and overwritten. The cache is best effort: any I/O failure just
+// means the tile gets generated again.
+class TileCache {
+public:
+  struct Key {
+    uint32_t generator; // bumped whenever the same seed would draw other stars
+    uint32_t tileSize;
+    uint32_t stars; // per tile
+    uint64_t seed;
+  };
+
+  TileCache(std::filesystem::path root, Key key)
+      : key(key), directory(std::move(root) /
+                            fmt::format("sky-{:016x}-{}-{}-v{}", key.seed,
+                                        key.tileSize, key.stars,
+                                        key.generator)) {}
+
+  // Fills `grey` with the cached tile, returns false if there is none.
+  bool load(sf::Vector2i coord, std::vector<uint8_t> &grey) const {
+    MappedFile file(path(coord));
+    const size_t pixels = static_cast<size_t>(key.tileSize) * key.tileSize;
+    if (!file || file.size() != sizeof(Header) + pixels)
+      return false;
+    Header header;
+    std::memcpy(&header, file.data(), sizeof(Header));
+    if (std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+        header.generator != key.generator ||
+        header.tileSize != key.tileSize || header.stars != key.stars ||
+        header.seed != key.seed || header.x != coord.x || header.y != coord.y)
+      return false;
+
+    const uint8_t *stored = file.data() + sizeof(Header);
+    grey.assign(stored, stored + pixels);
+    return true;
+  }
+
+  // Writes the tile next to its final name and renames it into place, so a
+  // reader never maps a half written file.
+  void store(sf::Vector2i coord, const std::vector<uint8_t> &grey) const {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+      return;
+
+    Header header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.generator = key.generator;
+    header.tileSize = key.tileSize;
+    header.stars = key.stars;
+    header.seed = key.seed;
+    header.x = coord.x;
+    header.y = coord.y;
+
+    auto target = path(coord);
+    auto partial = target;
+    partial += ".part";
+    {
+      std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char *>(grey.data()), grey.size());
+      if (!file)
+        return;
+    }
+    std::filesystem::rename(partial, target, error);
+  }
+
+private:
+  static constexpr char Magic[8] = {'A', 'T', 'S', 'T', 'I', 'L', 'E', '1'};
+
+  struct Header {
+    char magic[8];
+    uint32_t generator;
+    uint32_t tileSize;
+    uint32_t stars;
+    int32_t x, y;
+    uint32_t padding = 0;
+    uint64_t seed;
+  };
+
+  std::filesystem::path path(sf::Vector2i coord) const {
+    return directory / fmt::format("{}_{}.tile", coord.x, coord.y);
+  }
+
+  Key key;
+  std::filesystem::path directory;
+};
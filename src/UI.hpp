@@ -0,0 +1,320 @@
+#pragma once
+#include "GameObject.hpp"
+#include "Profiler.hpp"
+#include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/Graphics/Text.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fmt/format.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Text : public Movable, public Tickable, public Drawable {
+public:
+  Text() : textCallback(nullptr) {
+    txt.setFont(*TextureProvider::getDefaultFont());
+    txt.setCharacterSize(12);
+    txt.setFillColor(sf::Color::White);
+  }
+  Text(std::shared_ptr<std::function<std::string()>> callback)
+      : textCallback(callback) {
+    txt.setFont(*TextureProvider::getDefaultFont());
+    txt.setCharacterSize(12);
+    txt.setFillColor(sf::Color::White);
+  }
+  void setText(std::string text) { txt.setString(text); }
+  void setColor(sf::Color col) { txt.setFillColor(col); }
+  void setFontSize(int fontSize) { txt.setCharacterSize(fontSize); }
+  virtual void tick(float dt) override {
+    txt.setPosition(getPos());
+    if (textCallback) {
+      std::string data = (*textCallback)();
+      txt.setString(data);
+    }
+  }
+  virtual void draw(sf::RenderWindow &rw) override { rw.draw(txt); }
+
+  sf::Text &getUnderlayingType() { return txt; }
+
+private:
+  sf::Text txt;
+  std::shared_ptr<std::function<std::string()>> textCallback;
+};
+
+// HUD line showing up to two numbers. The numbers are formatted into a fixed
+// buffer only when they change, and the sf::Text (whose glyph geometry is
+// rebuilt on every setString) only when the formatted line does. The format
+// is checked against the two numbers at compile time.
+class HudText {
+public:
+  explicit HudText(fmt::format_string<float, float> format, int fontSize = 12,
+                   bool centered = false)
+      : format(format), centered(centered) {
+    txt.setFont(*TextureProvider::getDefaultFont());
+    txt.setCharacterSize(fontSize);
+    txt.setFillColor(sf::Color::White);
+  }
+
+  void set(float first, float second = 0) {
+    if (!line.empty() && first == values[0] && second == values[1])
+      return;
+    values[0] = first;
+    values[1] = second;
+    char buffer[sizeof(shown)];
+    auto result = fmt::vformat_to_n(buffer, sizeof(buffer) - 1, format,
+                                    fmt::make_format_args(first, second));
+    *result.out = '\0';
+    if (!line.empty() && std::strcmp(buffer, shown) == 0)
+      return;
+    std::memcpy(shown, buffer, sizeof(shown));
+    line = shown;
+    txt.setString(line);
+    if (centered) {
+      auto bounds = txt.getLocalBounds();
+      txt.setOrigin(bounds.left + bounds.width / 2.0f,
+                    bounds.top + bounds.height / 2.0f);
+    }
+    changed = true;
+  }
+
+  void setVisible(bool visible) {
+    changed |= visible != this->visible;
+    this->visible = visible;
+  }
+  void setOffset(sf::Vector2f offset) { txt.setPosition(offset); }
+
+private:
+  friend class Hud;
+  fmt::string_view format; // checked by the constructor
+  bool centered;
+  bool visible = true;
+  bool changed = false;
+  float values[2] = {0, 0};
+  char shown[64] = {};
+  std::string line;
+  sf::Text txt;
+};
+
+// HUD progress bar, only marked as changed when its fill moves by a pixel.
+class HudBar {
+public:
+  HudBar(float maxVal = 100, float width = 256, float height = 32)
+      : maxVal(maxVal) {
+    background.setSize({width, height});
+    fill.setSize({width - 10, height - 10});
+  }
+
+  void set(float val) {
+    float width = std::round((background.getSize().x - 10) * (val / maxVal));
+    if (width == fill.getSize().x)
+      return;
+    fill.setSize({width, fill.getSize().y});
+    changed = true;
+  }
+
+  void setFillColor(sf::Color color) { fill.setFillColor(color); }
+  void setBackgroundColor(sf::Color color) { background.setFillColor(color); }
+  void setOffset(sf::Vector2f offset) {
+    background.setPosition(offset);
+    fill.setPosition(offset + sf::Vector2f(5, 5));
+  }
+
+private:
+  friend class Hud;
+  float maxVal;
+  bool changed = false;
+  sf::RectangleShape background;
+  sf::RectangleShape fill;
+};
+
+// HUD elements laid out around an anchor (the player) and drawn as a single
+// cached layer of the viewport's size. Following the anchor only moves the
+// layer, it is redrawn when an element changed. Owners pull new values at
+// most RefreshRate times a second, see due.
+class Hud {
+public:
+  void add(HudText &text) { texts.push_back(&text); }
+  void add(HudBar &bar) { bars.push_back(&bar); }
+
+  // True when the values should be refreshed this tick, always on the first.
+  bool due(float dt) {
+    sinceRefresh += dt;
+    if (sinceRefresh < 1.0f / RefreshRate)
+      return false;
+    sinceRefresh = 0;
+    return true;
+  }
+
+  // Returns true if the size changed and the elements need a new layout.
+  // Offsets are relative to the anchor.
+  bool setSize(sf::Vector2f size) {
+    if (size == this->size)
+      return false;
+    this->size = size;
+    resized = true;
+    return true;
+  }
+
+  void draw(sf::RenderWindow &rw, sf::Vector2f anchor) {
+    if (size.x < 1 || size.y < 1)
+      return;
+    if (resized) {
+      layer.create(static_cast<unsigned>(std::ceil(size.x)),
+                   static_cast<unsigned>(std::ceil(size.y)));
+      sprite.setTexture(layer.getTexture(), true);
+    }
+    bool changed = resized;
+    for (auto *text : texts)
+      changed |= std::exchange(text->changed, false);
+    for (auto *bar : bars)
+      changed |= std::exchange(bar->changed, false);
+    if (changed) {
+      // Elements are placed around the anchor, which is the layer's center.
+      sf::RenderStates center(sf::Transform().translate(size / 2.0f));
+      layer.clear(sf::Color::Transparent);
+      for (auto *bar : bars) {
+        layer.draw(bar->background, center);
+        layer.draw(bar->fill, center);
+      }
+      for (auto *text : texts)
+        if (text->visible)
+          layer.draw(text->txt, center);
+      layer.display();
+      resized = false;
+    }
+    sprite.setPosition(anchor - size / 2.0f);
+    // The layer already has its colors multiplied by alpha.
+    rw.draw(sprite, sf::BlendMode(sf::BlendMode::One,
+                                  sf::BlendMode::OneMinusSrcAlpha));
+  }
+
+private:
+  static constexpr float RefreshRate = 10.0f; // per second
+
+  float sinceRefresh = 1.0f / RefreshRate; // the first update refreshes
+  sf::Vector2f size;
+  bool resized = false;
+  std::vector<HudText *> texts;
+  std::vector<HudBar *> bars;
+  sf::RenderTexture layer;
+  sf::Sprite sprite;
+};
+
+// Top-left table of the profiled scopes of the last second: milliseconds per
+// frame and calls per frame for each, slowest first. The table is rebuilt
+// once a second, from the events of every thread.
+class ProfilerOverlay : public Drawable {
+public:
+  ProfilerOverlay() {
+    txt.setFont(*TextureProvider::getDefaultFont());
+    txt.setCharacterSize(14);
+    txt.setFillColor(sf::Color::White);
+    txt.setOutlineColor(sf::Color::Black);
+    txt.setOutlineThickness(1);
+  }
+
+  void toggle() { visible = !visible; }
+
+  virtual void draw(sf::RenderWindow &rw) override {
+    if (!visible)
+      return;
+    int64_t now = Profiler::now();
+    if (now - windowStart >= 1000000000)
+      rebuild(now);
+    auto view = rw.getView();
+    rw.setView(rw.getDefaultView());
+    rw.draw(txt);
+    rw.setView(view);
+  }
+
+private:
+  struct Total {
+    int64_t duration = 0;
+    int64_t calls = 0;
+  };
+
+  void rebuild(int64_t now) {
+    std::unordered_map<std::string_view, Total> totals;
+    Profiler::forEachEvent(windowStart, [&](uint32_t, const auto &event) {
+      auto &total = totals[event.name];
+      total.duration += event.duration;
+      total.calls++;
+    });
+    windowStart = now;
+    double frames = std::max<int64_t>(totals["Frame"].calls, 1);
+
+    std::vector<std::pair<std::string_view, Total>> rows(totals.begin(),
+                                                         totals.end());
+    std::sort(rows.begin(), rows.end(), [](auto &a, auto &b) {
+      return a.second.duration > b.second.duration;
+    });
+    std::string table = fmt::format("{:<24}{:>10}{:>8}\n", "scope",
+                                    "ms/frame", "calls");
+    for (size_t i = 0; i < rows.size() && i < MaxRows; ++i) {
+      if (rows[i].second.calls == 0)
+        continue;
+      table += fmt::format("{:<24}{:>10.3f}{:>8.1f}\n", rows[i].first,
+                           rows[i].second.duration / 1e6 / frames,
+                           rows[i].second.calls / frames);
+    }
+    txt.setString(table);
+  }
+
+  static const size_t MaxRows = 24;
+  bool visible = false;
+  int64_t windowStart = 0;
+  sf::Text txt;
+};
+
+class Arrow : public GameObject, public Movable, public Tickable {
+public:
+  Arrow() : GameObject("./assets/Arrow.png", {0, 0}) {
+    sprite.setScale(0.25, 0.25);
+    sprite.setOrigin(textureSize.x / 2, textureSize.y / 2);
+  }
+  virtual void tick(float dt) override {
+    aim(origin, target.lock()->getPos());
+  }
+
+  // Turns towards target and moves onto a circle of 100 around origin.
+  void aim(sf::Vector2f origin, sf::Vector2f target) {
+    this->origin = origin;
+    calculateAngle(target);
+    sf::Vector2f newPos = {0, -100};
+    float anglerad = -angle * (M_PI / 180.0f);
+    newPos.x = newPos.x * cos(anglerad) - newPos.y * sin(anglerad);
+    newPos.y = newPos.y * cos(anglerad) + newPos.x * sin(anglerad);
+    newPos += origin;
+    setPosition(newPos);
+    // idk why
+    sprite.setRotation(-angle);
+  }
+
+  void calculateAngle() { calculateAngle(target.lock()->getPos()); }
+  void calculateAngle(sf::Vector2f t) {
+    // Calculate angle using atan2 (result is in radians, range: -π to +π)
+    angle = std::atan2(origin.x - t.x, origin.y - t.y);
+
+    // Convert to degrees and normalize to [0, 360]
+    angle = angle * (180.0f / M_PI); // Convert radians to degrees
+    if (angle < 0) {
+      angle += 360.0f; // Ensure non-negative angle
+    }
+  }
+
+  void setAngle(float angle) { this->angle = angle; }
+  void setOrigin(sf::Vector2f origin) { this->origin = origin; }
+  void setTarget(std::weak_ptr<Movable> target) { this->target = target; }
+
+protected:
+  sf::Vector2f origin = {0, 0};
+  float angle = 0;
+  std::weak_ptr<Movable> target;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <SFML/System/Vector2.hpp>
+#define _USE_MATH_DEFINES
+#include <cmath>
+#ifndef uint
+using uint = unsigned int;
+#endif
+inline int WINDOW_WIDTH = 1980;
+inline int WINDOW_HEIGHT = 1080;
+inline float VP_WIDTH = 0;
+inline float VP_HEIGHT = 0;
+const int MARGIN = 100;
+// Set when running without a window: nothing may touch the GPU or OpenGL.
+inline bool HEADLESS = false;
+template <typename T> T VecLength(sf::Vector2<T> vec) {
+  return std::sqrt(vec.x * vec.x + vec.y * vec.y);
+}
+
+template <typename T> sf::Vector2<T> &normalize(sf::Vector2<T> &vec) {
+  auto len = VecLength(vec);
+  vec /= len;
+  return vec;
+}
+
+template <typename T> T PointLen(sf::Vector2<T> p0, sf::Vector2<T> p1) {
+  sf::Vector2<T> vec = {p0.x - p1.x, p0.y - p1.y};
+  return VecLength<T>(vec);
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include "Asteroids.hpp"
+#include "Collisions.hpp"
+#include "Player.hpp"
+#include "Spaceship.hpp"
+#include "fmt/base.h"
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+// Who reacts to touching whom.
+inline void registerGameCollisions(CollisionMatrix &matrix) {
+  matrix.add<Asteroid, Player, &Asteroid::onColision>();
+  matrix.add<Asteroid, Asteroid, &Asteroid::onColision>();
+  matrix.add<Spaceship, Player, &Spaceship::onColision>();
+}
+
+// Starts decoding everything a level uses in the background, so building the
+// World mostly finds its assets ready.
+inline void prefetchLevelAssets() {
+  for (auto path : {"./assets/asteroid.png", "./assets/astronaut.png",
+                    "./assets/spaceship_scaled.png", "./assets/Arrow.png"})
+    TextureProvider::prefetch(path);
+  TextureProvider::prefetchDefaultFont();
+}
+
+// Smallest collision grid cell that finds every touching pair. Colliders are
+// binned by their position and a cell is only paired with its neighbours, so
+// the positions of two colliders that can touch must never be more than a
+// cell apart. Measured once on sample colliders, so it looks textures up:
+// call it on the main thread.
+inline int minGridSize() {
+  static const int size = [] {
+    CollisionMatrix matrix;
+    registerGameCollisions(matrix);
+    Random random;
+    auto astronaut = std::filesystem::path("./assets/astronaut.png");
+    std::shared_ptr<GameObject> samples[] = {
+        std::make_shared<Player>(astronaut, sf::Vector2f{0, 0}),
+        std::make_shared<Spaceship>(0.0f, random),
+        std::make_shared<Asteroid>(random)};
+    float reach = 0;
+    for (auto &a : samples)
+      for (auto &b : samples) {
+        if (!matrix.handles(a->getLayer(), b->getLayer()))
+          continue;
+        // How far past a's position b's can be while their bounds overlap.
+        WorldBounds boundsA = a->updateBounds(), boundsB = b->updateBounds();
+        sf::Vector2f posA = a->getSprite().getPosition();
+        sf::Vector2f posB = b->getSprite().getPosition();
+        reach = std::max({reach, boundsA.right - posA.x + posB.x - boundsB.left,
+                          boundsA.bottom - posA.y + posB.y - boundsB.top});
+      }
+    return static_cast<int>(std::ceil(reach));
+  }();
+  return size;
+}
+
+// What drawing a tick needs, copied out of the World so the renderer never
+// reads objects the simulation is updating. Velocities let it place things
+// between two ticks.
+struct WorldSnapshot {
+  sf::Vector2f player, playerVelocity;
+  sf::Vector2f spaceship;
+  PlayerStatus status;
+  std::vector<sf::Vector2f> asteroids, asteroidVelocities;
+};
+
+struct WorldOptions {
+  bool asteroidField = false;  // keep asteroids in an AsteroidField
+  uint64_t seed = 0;           // the same seed and level lay out the same world
+  int maxAsteroids = 0;        // 0 = 10 + level
+  int gridSize = 256;          // collision cell, at least minGridSize()
+  int dormantAsteroids = 4096; // kept out of range, 0 = despawn them
+};
+
+// Random streams of the subsystems placing things in a level.
+enum class RandomStream : uint64_t { Spaceship = 1, Asteroids };
+
+// Everything that takes part in the simulation of a single level. Owns no
+// window or render target so it can be ticked headless as well.
+class World {
+public:
+  World(int level, WorldOptions options = {})
+      : collisions(options.gridSize) {
+    fmt::println("Placing the Spaceship");
+    Random random = Random(options.seed).split(level);
+    auto stream = [&](RandomStream id) {
+      return random.split(static_cast<uint64_t>(id));
+    };
+    float minDistanceFromPlayer = 512.0f + level * 100.0f;
+    spaceship = std::make_shared<Spaceship>(minDistanceFromPlayer,
+                                            stream(RandomStream::Spaceship));
+    player = std::make_shared<Player>(
+        std::filesystem::path("./assets/astronaut.png"), sf::Vector2f{0, 0});
+    asteroids = std::make_shared<Asteroids>(
+        player, options.maxAsteroids ? options.maxAsteroids : 10 + level,
+        options.asteroidField, stream(RandomStream::Asteroids),
+        options.gridSize, std::max(options.dormantAsteroids, 0));
+    asteroids->setPlayer(player);
+    tickable = {spaceship, asteroids, player};
+    tickNames = {"Tick spaceship", "Tick asteroids", "Tick player"};
+    registerGameCollisions(collisions.matrix);
+  }
+
+  void tick(float dt, const inputs &input) {
+    PROFILE_SCOPE("World tick");
+    for (size_t i = 0; i < tickable.size(); ++i) {
+      PROFILE_SCOPE(tickNames[i]);
+      tickable[i]->tick(dt, input);
+    }
+
+    {
+      PROFILE_SCOPE("Rebuild colisable");
+      colisable.clear();
+      colisable.push_back(player);
+      colisable.push_back(spaceship);
+      for (auto &asteroid : asteroids->getAsteroids())
+        colisable.push_back(asteroid);
+    }
+    PROFILE_SCOPE("Check collisions");
+    asteroids->checkFieldCollisions();
+    checkCollisions(collisions, colisable, dt);
+  }
+
+  bool isOver() const { return player->isWon() || player->isDead(); }
+
+  // Fills `out`, reusing the storage it already has.
+  void snapshot(WorldSnapshot &out) const {
+    out.player = player->getPos();
+    out.playerVelocity = player->getAcc();
+    out.spaceship = spaceship->getPos();
+    out.status = player->status();
+    out.asteroids.clear();
+    out.asteroidVelocities.clear();
+    for (auto &asteroid : asteroids->getAsteroids()) {
+      out.asteroids.push_back(asteroid->getPos());
+      out.asteroidVelocities.push_back(asteroid->getAcc());
+    }
+    auto &field = asteroids->getField();
+    for (size_t i = 0; i < field.size(); ++i) {
+      out.asteroids.push_back(field.position(i));
+      out.asteroidVelocities.push_back(field.velocity(i));
+    }
+  }
+
+  std::shared_ptr<Spaceship> spaceship;
+  std::shared_ptr<Player> player;
+  std::shared_ptr<Asteroids> asteroids;
+
+private:
+  std::vector<std::shared_ptr<Tickable>> tickable;
+  std::vector<const char *> tickNames; // profiler scope of each tickable
+  std::vector<std::shared_ptr<GameObject>> colisable;
+  CollisionState collisions;
+};
+
+inline void finishLevel(Player &player) {
+  if (player.isWon())
+    player.updatePlayerGlobalScore();
+  else
+    PlayerGameScore = 0;
+}
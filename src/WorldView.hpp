@@ -0,0 +1,69 @@
+#pragma once
+#include "Culling.hpp"
+#include "PlayerHud.hpp"
+#include "World.hpp"
+
+// Draws a World from snapshots, placed between the last two ticks. Has its
+// own copies of the sprites, so it can run while another thread ticks the
+// World.
+class WorldView {
+public:
+  // Call before the World is ticked from another thread.
+  explicit WorldView(const World &world)
+      : spaceship(world.spaceship->getSprite()),
+        player(world.player->getSprite()),
+        asteroid(world.asteroids->getSprite()) {}
+
+  // `alpha` is how far past `previous` to draw, in ticks of `dt` seconds;
+  // `frameDt` is the time since the last frame.
+  void update(const WorldSnapshot &previous, const WorldSnapshot &current,
+              float alpha, float dt, float frameDt) {
+    center = previous.player + (current.player - previous.player) * alpha;
+    player.setPosition(center);
+
+    // Asteroids come and go between ticks, so rather than matching them up
+    // with the previous snapshot each is moved back along its velocity.
+    float behind = (1.0f - alpha) * dt;
+    asteroids.resize(current.asteroids.size());
+    for (size_t i = 0; i < asteroids.size(); ++i)
+      asteroids[i] =
+          current.asteroids[i] - current.asteroidVelocities[i] * behind;
+
+    hud.update(center, current.playerVelocity, current.spaceship,
+               current.status, frameDt);
+  }
+
+  // Where the camera should look.
+  sf::Vector2f getCenter() const { return center; }
+
+  // Of the last drawBatched; the player is always drawn and not counted.
+  const CullStats &getCullStats() const { return cullStats; }
+
+  // Only what overlaps the window's current view goes into the batch.
+  void drawBatched(sf::RenderWindow &rw, SpriteBatch &batch) {
+    const sf::View &view = rw.getView();
+    cullStats = {};
+    if (StampCuller(view, spaceship).keep(spaceship.getPosition(), cullStats))
+      batch.add(spaceship);
+    StampCuller culler(view, asteroid);
+    for (auto pos : asteroids) {
+      if (!culler.keep(pos, cullStats))
+        continue;
+      asteroid.setPosition(pos);
+      batch.add(asteroid);
+    }
+    // The HUD is not batched, only the player goes on top of it.
+    batch.flush(rw);
+    hud.draw(rw);
+    batch.add(player);
+  }
+
+private:
+  sf::Sprite spaceship; // never moves
+  sf::Sprite player;
+  sf::Sprite asteroid; // stamped at every asteroid position
+  std::vector<sf::Vector2f> asteroids;
+  sf::Vector2f center;
+  PlayerHud hud;
+  CullStats cullStats;
+};